@@ -133,7 +133,7 @@ def bits_to_ascii(bit_string):
 # -----------------------------
 def handle_raw_bits(bit_list):
     """
-    Accepts newly arrived bits from the ring buffer. 
+    Accepts newly arrived bits from the decoder's bit queue.
     We'll only do something if we're in a "message" state or we see a preamble.
     """
     global in_message
@@ -0,0 +1,183 @@
+/*
+ * demod_compare.c
+ *
+ * Run several configurations of the viperwolf AFSK demodulator over the
+ * same raw audio (16-bit mono) and report, for each one, how many bits
+ * differ from the first (reference) configuration and how long it took.
+ *
+ * Usage example:
+ *    arecord -f S16_LE -c1 -r48000 | ./demod_compare 48000 300 1200 2200 A
+ *    ./demod_compare 44100 1200 1200 2200 A 500 < packets.raw
+ *
+ * The optional last argument adds white noise of that RMS (in sample
+ * units) to the input, to compare the variants at a lower SNR.
+ *
+ * With profile A, the "sdft" row is profile G (sliding DFT) on the same
+ * audio: its speed and how far its bits are from A's. The "butter" and
+ * "cheby" rows swap the FIR prefilter for the IIR ones, "kaiser" and
+ * "remez" for the shorter spec-sized FIRs (opts.filter_design). "f16" and
+ * "bf16" keep the delay lines in 16 bits (opts.half_storage); their bit
+ * differences are the accuracy cost against the float reference.
+ *
+ * Compile: see demod_compare.txt
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "demod_afsk.h"
+#include "my_fsk.h"
+
+struct demodulator_state_s *create_demodulator_state(void);
+void free_demodulator_state(struct demodulator_state_s *p);
+
+/* Audio is fed in chunks of this many samples. */
+#define CHUNK_LEN 1024
+
+/* Largest alignment shift tried between two bit streams. Different
+   profiles emit different numbers of noise bits before a signal. */
+#define MAX_SHIFT 64
+
+struct variant {
+    const char *name;
+    const char *profiles;    /* profiles it applies to, NULL = all */
+    char as;                 /* run as this profile instead, 0 = as given */
+    struct demod_afsk_opts_s opts;
+    struct demodulator_state_s *D;
+    char *bits;          /* '0'/'1' per recovered bit */
+    int nbits;
+    int cap;
+    double seconds;
+};
+
+static void collect_bits(struct variant *v)
+{
+    int out[1024];
+    int k;
+    while ((k = my_fsk_queue_get_bits(demod_afsk_queue(v->D, 0), out, 1024)) > 0) {
+        if (v->nbits + k > v->cap) {
+            v->cap = 2 * (v->nbits + k);
+            v->bits = realloc(v->bits, v->cap);
+            if (!v->bits) { perror("realloc"); exit(1); }
+        }
+        for (int j = 0; j < k; j++) v->bits[v->nbits++] = (char)('0' + out[j]);
+    }
+}
+
+/* Fewest differing bits over small relative shifts of the two streams,
+   since the variants may lock a bit earlier or later. */
+static int compare_bits(const struct variant *ref, const struct variant *v, int *shift, int *overlap)
+{
+    int best = -1;
+    for (int s = -MAX_SHIFT; s <= MAX_SHIFT; s++) {
+        const char *a = ref->bits + (s > 0 ? s : 0);
+        const char *b = v->bits + (s < 0 ? -s : 0);
+        int na = ref->nbits - (s > 0 ? s : 0);
+        int nb = v->nbits - (s < 0 ? -s : 0);
+        int n = na < nb ? na : nb;
+        if (n <= 0) continue;
+        int e = 0;
+        for (int i = 0; i < n; i++) e += (a[i] != b[i]);
+        if (best < 0 || e < best) { best = e; *shift = s; *overlap = n; }
+    }
+    return best;
+}
+
+/* Gaussian noise, Box-Muller. */
+static float gauss(void)
+{
+    double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return (float)(sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2));
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 6) {
+        fprintf(stderr, "usage: %s rate baud mark space profile [noise_rms] < audio.raw\n", argv[0]);
+        return 1;
+    }
+    int rate = atoi(argv[1]), baud = atoi(argv[2]);
+    int mark = atoi(argv[3]), space = atoi(argv[4]);
+    char profile = argv[5][0];
+    float noise = argc > 6 ? (float)atof(argv[6]) : 0.0f;
+
+    struct variant all[] = {
+        { .name = "float" },
+        { .name = "q15",   .profiles = "ABDE" },
+        { .name = "conj",  .profiles = "BCD" },
+        { .name = "cross", .profiles = "BCD" },
+        { .name = "sdft",  .profiles = "AE", .as = 'G' },
+        { .name = "butter", .profiles = "ABCDE" },
+        { .name = "cheby", .profiles = "ABCDE" },
+        { .name = "kaiser", .profiles = "ABCDE" },
+        { .name = "remez", .profiles = "ABCDE" },
+        { .name = "f16",   .profiles = "ABCDE" },
+        { .name = "bf16",  .profiles = "ABCDE" },
+    };
+    struct variant v[sizeof(all) / sizeof(all[0])];
+    int nv = 0;
+
+    for (size_t i = 0; i < sizeof(all) / sizeof(all[0]); i++) {
+        if (all[i].profiles && !strchr(all[i].profiles, profile)) continue;
+        v[nv] = all[i];
+        demod_afsk_default_opts(&v[nv].opts);
+        if (!strcmp(v[nv].name, "q15"))   v[nv].opts.fixed_point = 1;
+        if (!strcmp(v[nv].name, "conj"))  v[nv].opts.fm_disc = FM_DISC_CONJ;
+        if (!strcmp(v[nv].name, "cross")) v[nv].opts.fm_disc = FM_DISC_CROSS;
+        if (!strcmp(v[nv].name, "butter")) v[nv].opts.prefilter_iir = IIR_BUTTERWORTH;
+        if (!strcmp(v[nv].name, "cheby")) v[nv].opts.prefilter_iir = IIR_CHEBYSHEV;
+        if (!strcmp(v[nv].name, "kaiser")) v[nv].opts.filter_design = FILTER_DESIGN_KAISER;
+        if (!strcmp(v[nv].name, "remez")) v[nv].opts.filter_design = FILTER_DESIGN_EQUIRIPPLE;
+        if (!strcmp(v[nv].name, "f16"))   v[nv].opts.half_storage = HALF_STORAGE_F16;
+        if (!strcmp(v[nv].name, "bf16"))  v[nv].opts.half_storage = HALF_STORAGE_BF16;
+        nv++;
+    }
+
+    for (int i = 0; i < nv; i++) {
+        v[i].D = create_demodulator_state();
+        if (!v[i].D) { fprintf(stderr, "out of memory\n"); return 1; }
+        demod_afsk_init_opts(rate, baud, mark, space, v[i].as ? v[i].as : profile, &v[i].opts, v[i].D);
+    }
+
+    /* Each variant drains its queue after every chunk, before it fills. */
+    int16_t buf[CHUNK_LEN];
+    long total = 0;
+    size_t n;
+    while ((n = fread(buf, sizeof(int16_t), CHUNK_LEN, stdin)) > 0) {
+        if (noise > 0.0f) {
+            for (size_t j = 0; j < n; j++) {
+                long s = lrintf(buf[j] + noise * gauss());
+                buf[j] = (int16_t)(s > 32767 ? 32767 : (s < -32768 ? -32768 : s));
+            }
+        }
+        for (int i = 0; i < nv; i++) {
+            clock_t t0 = clock();
+            demod_afsk_process_block_s16(0, 0, buf, (int)n, v[i].D);
+            v[i].seconds += (double)(clock() - t0) / CLOCKS_PER_SEC;
+            collect_bits(&v[i]);
+        }
+        total += (long)n;
+    }
+
+    printf("%ld samples, %.2f s of audio, profile %c, %d baud\n",
+           total, (double)total / rate, profile, baud);
+    printf("%-8s %8s %8s %8s %10s %10s\n", "variant", "bits", "differ", "shift", "ratio", "ns/sample");
+    for (int i = 0; i < nv; i++) {
+        int shift = 0, overlap = v[i].nbits;
+        int e = (i == 0) ? 0 : compare_bits(&v[0], &v[i], &shift, &overlap);
+        printf("%-8s %8d %8d %8d %10.2e %10.1f\n", v[i].name, v[i].nbits, e, shift,
+               overlap > 0 ? (double)e / overlap : 0.0,
+               total > 0 ? v[i].seconds * 1e9 / total : 0.0);
+    }
+
+    for (int i = 0; i < nv; i++) {
+        free_demodulator_state(v[i].D);
+        free(v[i].bits);
+    }
+    return 0;
+}
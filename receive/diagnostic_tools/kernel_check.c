@@ -0,0 +1,264 @@
+/*
+ * kernel_check.c
+ *
+ * Check the FIR kernels of one instruction set (convolve.h) against a
+ * double-precision reference for every tap count from 1 up: dot, dot2,
+ * dot4 and their folded (symmetric) variants, dotn and dotn_sym, the Q15
+ * kernel, and the f16/bf16 pack and dot kernels. The kernel set is the one
+ * convolve_select() picks, so TUNE_SIMD=<name> checks another.
+ *
+ * Usage example:
+ *    TUNE_SIMD=avx2 ./kernel_check 600
+ *
+ * The argument is the longest filter checked (default 600). Prints one
+ * line per kernel with the worst error relative to its bound, and exits
+ * with 1 if any kernel is out of bounds.
+ *
+ * Compile: see kernel_check.txt
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "convolve.h"
+
+/* Widest lane count given to dotn. */
+#define MAX_LANES 16
+
+/* Worst error seen per kernel, as a fraction of the bound; > 1 fails. */
+struct result_s {
+    const char *name;
+    double worst;
+    int worst_taps;
+};
+
+static unsigned int seed = 1;
+
+static float frand(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return (float)((seed >> 8) & 0xffff) / 32768.0f - 1.0f;
+}
+
+static int irand(int range)
+{
+    seed = seed * 1103515245u + 12345u;
+    return (int)((seed >> 8) % (2 * range + 1)) - range;
+}
+
+static void note(struct result_s *r, double err, double bound, int taps)
+{
+    double q = (bound > 0) ? err / bound : (err > 0 ? INFINITY : 0);
+    if (q > r->worst || isnan(q)) {
+        r->worst = q;
+        r->worst_taps = taps;
+    }
+}
+
+/*
+ * Any summation order of n products is within n*FLT_EPSILON of the sum of
+ * their magnitudes (twice the textbook bound); the folded kernels round
+ * once more when adding the mirrored samples.
+ */
+static double bound_for(int taps, double sum_abs)
+{
+    return (taps + 2) * FLT_EPSILON * sum_abs + FLT_MIN;
+}
+
+/* Value of an IEEE half / bfloat16 bit pattern. */
+static double f16_value(uint16_t h)
+{
+    int e = (h >> 10) & 31, m = h & 1023;
+    double v;
+    if (e == 0) {
+        v = ldexp(m, -24);
+    } else if (e == 31) {
+        v = m ? NAN : INFINITY;
+    } else {
+        v = ldexp(m + 1024, e - 25);
+    }
+    return (h & 0x8000) ? -v : v;
+}
+
+static double bf16_value(uint16_t b)
+{
+    uint32_t u = (uint32_t)b << 16;
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+/* lanes streams of 'taps' samples, lane j of sample i at data[i*lanes+j]. */
+static void check_float(const struct convolve_ops_s *ops, struct result_s *res,
+                        float *data, float *filt, int taps)
+{
+    /* Plain filter, then the same made symmetric. */
+    for (int sym = 0; sym < 2; sym++) {
+        if (sym) {
+            for (int i = 0; i < taps / 2; i++) {
+                filt[taps - 1 - i] = filt[i];
+            }
+        }
+        for (int lanes = 1; lanes <= 4; lanes *= 2) {
+            float *d = data;
+            float out[4];
+            struct result_s *r = &res[sym * 3 + (lanes == 1 ? 0 : lanes == 2 ? 1 : 2)];
+
+            if (lanes == 1) {
+                out[0] = (sym ? ops->dot_sym : ops->dot)(d, filt, taps);
+            } else if (lanes == 2) {
+                (sym ? ops->dot2_sym : ops->dot2)(d, filt, taps, out);
+            } else {
+                (sym ? ops->dot4_sym : ops->dot4)(d, filt, taps, out);
+            }
+            for (int j = 0; j < lanes; j++) {
+                double ref = 0, mag = 0;
+                for (int i = 0; i < taps; i++) {
+                    ref += (double)d[i * lanes + j] * filt[i];
+                    mag += fabs((double)d[i * lanes + j] * filt[i]);
+                }
+                note(r, fabs(out[j] - ref), bound_for(taps, mag), taps);
+            }
+        }
+        for (int lanes = 4; lanes <= MAX_LANES; lanes += 4) {
+            float out[MAX_LANES];
+            (sym ? ops->dotn_sym : ops->dotn)(data, filt, taps, lanes, out);
+            for (int j = 0; j < lanes; j++) {
+                double ref = 0, mag = 0;
+                for (int i = 0; i < taps; i++) {
+                    ref += (double)data[i * lanes + j] * filt[i];
+                    mag += fabs((double)data[i * lanes + j] * filt[i]);
+                }
+                note(&res[6 + sym], fabs(out[j] - ref), bound_for(taps, mag), taps);
+            }
+        }
+    }
+}
+
+static void check_q15(const struct convolve_ops_s *ops, struct result_s *r, int taps)
+{
+    /* Small enough that the exact sum fits in 32 bits up to 4096 taps. */
+    int16_t *data = malloc(taps * sizeof(int16_t));
+    int16_t *filt = malloc(taps * sizeof(int16_t));
+    int64_t ref = 0;
+
+    for (int i = 0; i < taps; i++) {
+        data[i] = (int16_t)irand(16383);
+        filt[i] = (int16_t)irand(31);
+        ref += (int64_t)data[i] * filt[i];
+    }
+    int32_t got = ops->dot_q15(data, filt, taps);
+    note(r, (double)llabs((int64_t)got - ref), 0, taps);
+    free(data);
+    free(filt);
+}
+
+/*
+ * 'unit' is the format's unit in the last place at 1.0 and 'tiny' half
+ * its smallest step (subnormals).
+ */
+static void check_half(const struct convolve_half_ops_s *h, double (*value)(uint16_t),
+                       double unit, double tiny, struct result_s *res, const float *src,
+                       float *filt, int taps)
+{
+    int n = 4 * taps;
+    uint16_t *data = malloc(n * sizeof(uint16_t));
+
+    /* Packing rounds to nearest: within half a unit of the last place. */
+    h->pack(src, data, n);
+    for (int i = 0; i < n; i++) {
+        double w = value(data[i]);
+        int e;
+        frexp(src[i], &e);
+        note(&res[0], fabs(w - src[i]), fmax(ldexp(unit, e - 2), tiny), taps);
+    }
+
+    for (int lanes = 1; lanes <= 4; lanes *= 2) {
+        float out[4];
+        struct result_s *r = &res[lanes == 1 ? 1 : lanes == 2 ? 2 : 3];
+
+        if (lanes == 1) {
+            out[0] = h->dot(data, filt, taps);
+        } else if (lanes == 2) {
+            h->dot2(data, filt, taps, out);
+        } else {
+            h->dot4(data, filt, taps, out);
+        }
+        for (int j = 0; j < lanes; j++) {
+            double ref = 0, mag = 0;
+            for (int i = 0; i < taps; i++) {
+                double v = value(data[i * lanes + j]);
+                ref += v * filt[i];
+                mag += fabs(v * filt[i]);
+            }
+            note(r, fabs(out[j] - ref), bound_for(taps, mag), taps);
+        }
+    }
+    free(data);
+}
+
+int main(int argc, char **argv)
+{
+    int max_taps = argc > 1 ? atoi(argv[1]) : 600;
+    const struct convolve_ops_s *ops = convolve_select();
+    static const char *names[] = {
+        "dot", "dot2", "dot4", "dot_sym", "dot2_sym", "dot4_sym",
+        "dotn", "dotn_sym", "dot_q15",
+        "f16 pack", "f16 dot", "f16 dot2", "f16 dot4",
+        "bf16 pack", "bf16 dot", "bf16 dot2", "bf16 dot4",
+    };
+    enum { NRES = sizeof(names) / sizeof(names[0]) };
+    struct result_s res[NRES];
+    int nres = NRES;
+    int failed = 0;
+
+    if (max_taps < 1) {
+        fprintf(stderr, "usage: %s [max_taps]\n", argv[0]);
+        return 1;
+    }
+    for (int k = 0; k < nres; k++) {
+        res[k].name = names[k];
+        res[k].worst = 0;
+        res[k].worst_taps = 0;
+    }
+
+    for (int taps = 1; taps <= max_taps; taps++) {
+        /*
+         * No padding past what dotn reads at MAX_LANES, so that a build
+         * with -fsanitize=address catches reads past the end; the offset
+         * keeps the windows unaligned, as in a delay line.
+         */
+        int off = taps % 7;
+        float *buf = malloc((off + MAX_LANES * taps) * sizeof(float));
+        float *filt = malloc(taps * sizeof(float));
+        float *data = buf + off;
+
+        for (int i = 0; i < off + MAX_LANES * taps; i++) {
+            buf[i] = frand();
+        }
+        for (int i = 0; i < taps; i++) {
+            filt[i] = frand();
+        }
+
+        check_half(&ops->f16, f16_value, ldexp(1, -10), ldexp(1, -25), &res[9], data, filt, taps);
+        check_half(&ops->bf16, bf16_value, ldexp(1, -7), FLT_MIN, &res[13], data, filt, taps);
+        check_float(ops, res, data, filt, taps);
+        check_q15(ops, &res[8], taps);
+
+        free(buf);
+        free(filt);
+    }
+
+    printf("%s, taps 1..%d (error / bound, worst at):\n", ops->name, max_taps);
+    for (int k = 0; k < nres; k++) {
+        int bad = !(res[k].worst <= 1.0);
+        printf("  %-10s %9.3g  %4d  %s\n", res[k].name, res[k].worst, res[k].worst_taps,
+               bad ? "FAIL" : "ok");
+        failed |= bad;
+    }
+    return failed;
+}
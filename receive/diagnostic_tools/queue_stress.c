@@ -0,0 +1,127 @@
+/*
+ * queue_stress.c
+ *
+ * Stress the lock-free bit queue of my_fsk.c: one thread puts a known bit
+ * sequence as fast as it can, the main thread takes it concurrently,
+ * rotating through my_fsk_queue_get_words(), _get_bytes() and _get_bits()
+ * with varying lengths, and checks every bit it gets. The producer retries
+ * when the queue is full, so no bit may be lost, repeated or reordered.
+ *
+ * Built with -fsanitize=thread it checks the memory ordering as well; see
+ * queue_stress.txt.
+ *
+ * Usage example:
+ *    ./queue_stress 3000000
+ *
+ * The argument is the number of bits (default 3000000). Exits with 1 on
+ * the first wrong bit.
+ *
+ * Compile: see queue_stress.txt
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "my_fsk.h"
+
+/* Longest single take, in bits. */
+#define MAX_TAKE 300
+
+struct producer_s {
+    struct my_fsk_queue_s *q;
+    uint64_t nbits;
+    uint64_t full;          /* puts refused because the queue was full */
+};
+
+/* Bit i of the sequence: a hash, so neither side can fall into step. */
+static int bit_at(uint64_t i)
+{
+    return (int)(((i + 1) * 0x9E3779B97F4A7C15ull) >> 63);
+}
+
+static void *producer(void *arg)
+{
+    struct producer_s *p = arg;
+
+    for (uint64_t i = 0; i < p->nbits; i++) {
+        while (!my_fsk_queue_put(p->q, bit_at(i))) {
+            p->full++;
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t nbits = argc > 1 ? strtoull(argv[1], NULL, 10) : 3000000;
+    static struct my_fsk_queue_s q;
+    struct producer_s p = { &q, nbits, 0 };
+    pthread_t tid;
+    uint64_t got = 0, takes = 0, empty = 0;
+    int mode = 0, want = 1;
+
+    my_fsk_queue_init(&q);
+    if (pthread_create(&tid, NULL, producer, &p) != 0) {
+        fprintf(stderr, "pthread_create failed\n");
+        return 1;
+    }
+
+    while (got < nbits) {
+        uint64_t words[(MAX_TAKE + 63) / 64];
+        uint8_t bytes[(MAX_TAKE + 7) / 8];
+        int bits[MAX_TAKE];
+        int n;
+
+        if (my_fsk_queue_count(&q) == 0) {
+            empty++;
+            sched_yield();
+            continue;
+        }
+
+        /* Lengths that straddle word and byte boundaries. */
+        want = (want + 6) % MAX_TAKE + 1;
+        switch (mode) {
+        case 0:
+            n = my_fsk_queue_get_words(&q, words, want);
+            for (int i = 0; i < n; i++) {
+                bits[i] = (int)((words[i / 64] >> (i % 64)) & 1);
+            }
+            break;
+        case 1:
+            n = my_fsk_queue_get_bytes(&q, bytes, want);
+            for (int i = 0; i < n; i++) {
+                bits[i] = (bytes[i / 8] >> (i % 8)) & 1;
+            }
+            break;
+        default:
+            n = my_fsk_queue_get_bits(&q, bits, want);
+            break;
+        }
+        mode = (mode + 1) % 3;
+        takes++;
+
+        for (int i = 0; i < n; i++) {
+            if (bits[i] != bit_at(got + i)) {
+                fprintf(stderr, "bit %llu: got %d, expected %d (take %llu, %d of %d bits)\n",
+                        (unsigned long long)(got + i), bits[i], bit_at(got + i),
+                        (unsigned long long)takes, n, want);
+                return 1;
+            }
+        }
+        got += n;
+    }
+    pthread_join(tid, NULL);
+
+    if (my_fsk_queue_count(&q) != 0) {
+        fprintf(stderr, "%d bits left over\n", my_fsk_queue_count(&q));
+        return 1;
+    }
+    printf("%llu bits ok in %llu takes; queue full %llu times, empty %llu times\n",
+           (unsigned long long)got, (unsigned long long)takes,
+           (unsigned long long)p.full, (unsigned long long)empty);
+    return 0;
+}
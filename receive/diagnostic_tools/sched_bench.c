@@ -0,0 +1,127 @@
+/*
+ * sched_bench.c
+ *
+ * Replay one recording (16-bit mono) on several channels at once through
+ * the demod_sched worker pool and report the throughput and how busy each
+ * worker was. Run it with 1, 2, 4... workers to see how decoding scales
+ * with cores.
+ *
+ * Usage example:
+ *    ./sched_bench 48000 1200 1200 2200 A 16 4 < packets.raw
+ *
+ * Arguments after the profile: channels, workers (0 = one per CPU), and
+ * optionally 0 to leave the workers unpinned.
+ *
+ * Compile: see sched_bench.txt
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "demod_afsk.h"
+#include "demod_sched.h"
+#include "my_fsk.h"
+
+struct demodulator_state_s *create_demodulator_state(void);
+void free_demodulator_state(struct demodulator_state_s *p);
+
+/* Samples per channel per round. */
+#define BLOCK_LEN 1024
+
+static double now_sec(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 8) {
+        fprintf(stderr, "usage: %s rate baud mark space profile channels workers [pin] < audio.raw\n", argv[0]);
+        return 1;
+    }
+    int rate = atoi(argv[1]), baud = atoi(argv[2]);
+    int mark = atoi(argv[3]), space = atoi(argv[4]);
+    char profile = argv[5][0];
+    int nchan = atoi(argv[6]), nworkers = atoi(argv[7]);
+    int pin = argc > 8 ? atoi(argv[8]) : 1;
+
+    if (nchan < 1) {
+        fprintf(stderr, "channels must be at least 1\n");
+        return 1;
+    }
+
+    /* Whole recording in memory, so only demodulation is timed. */
+    size_t cap = 1 << 20, total = 0, n;
+    int16_t *audio = malloc(cap * sizeof(int16_t));
+    while (audio && (n = fread(audio + total, sizeof(int16_t), cap - total, stdin)) > 0) {
+        total += n;
+        if (total == cap) {
+            int16_t *more = realloc(audio, (cap *= 2) * sizeof(int16_t));
+            if (!more) { fprintf(stderr, "out of memory\n"); return 1; }
+            audio = more;
+        }
+    }
+    if (!audio || total == 0) { fprintf(stderr, "no audio\n"); return 1; }
+
+    struct demod_sched_s *S = demod_sched_create(nworkers, pin, nchan);
+    if (!S) { fprintf(stderr, "could not start workers\n"); return 1; }
+
+    struct demodulator_state_s **D = calloc(nchan, sizeof(*D));
+    long *bits = calloc(nchan, sizeof(*bits));
+    const int16_t **blocks = calloc(nchan, sizeof(*blocks));
+    int *counts = calloc(nchan, sizeof(*counts));
+    if (!D || !bits || !blocks || !counts) { fprintf(stderr, "out of memory\n"); return 1; }
+    for (int c = 0; c < nchan; c++) {
+        D[c] = create_demodulator_state();
+        if (!D[c]) { fprintf(stderr, "out of memory\n"); return 1; }
+        demod_afsk_init(rate, baud, mark, space, profile, D[c]);
+        demod_sched_add(S, c, D[c]);
+    }
+
+    int out[1024];
+
+    demod_sched_reset_stats(S);
+    double t0 = now_sec();
+    for (size_t i = 0; i < total; i += BLOCK_LEN) {
+        for (int c = 0; c < nchan; c++) {
+            blocks[c] = audio + i;
+            counts[c] = (int)(total - i < BLOCK_LEN ? total - i : BLOCK_LEN);
+        }
+        demod_sched_process_s16(S, blocks, counts);
+        for (int c = 0; c < nchan; c++) {
+            int k;
+            while ((k = my_fsk_queue_get_bits(demod_afsk_queue(D[c], 0), out, 1024)) > 0) bits[c] += k;
+        }
+    }
+    double elapsed = now_sec() - t0;
+
+    double audio_sec = (double)total / rate;
+    printf("%d channels x %.2f s of audio, profile %c, %d baud, %d workers\n",
+           nchan, audio_sec, profile, baud, demod_sched_num_workers(S));
+    printf("%.3f s elapsed, %.1f x real time per channel, %.1f channels in real time\n",
+           elapsed, audio_sec / elapsed, nchan * audio_sec / elapsed);
+    printf("%-6s %4s %8s %10s %8s %8s\n", "worker", "cpu", "channels", "samples", "busy s", "util");
+    for (int w = 0; w < demod_sched_num_workers(S); w++) {
+        struct demod_sched_stats_s st;
+        demod_sched_get_stats(S, w, &st);
+        printf("%-6d %4d %8d %10ld %8.3f %7.1f%%\n", w, st.cpu, st.channels, st.samples,
+               st.busy_sec, 100.0 * st.utilization);
+    }
+    printf("bits per channel:");
+    for (int c = 0; c < nchan; c++) printf(" %ld", bits[c]);
+    printf("\n");
+
+    demod_sched_free(S);
+    for (int c = 0; c < nchan; c++) free_demodulator_state(D[c]);
+    free(counts);
+    free(blocks);
+    free(bits);
+    free(D);
+    free(audio);
+    return 0;
+}
@@ -25,9 +25,91 @@ ffibuilder.cdef(r"""
                                    int sam,
                                    struct demodulator_state_s *D);
 
-    void my_fsk_rec_bit(int bit);
-    int my_fsk_get_bits(int *out_bits, int max_bits);
-    void my_fsk_clear_buffer(void);
+    void demod_afsk_process_block_s16(int chan, int subchan,
+                                      const int16_t *samples, int count,
+                                      struct demodulator_state_s *D);
+
+    void demod_afsk_process_block_f32(int chan, int subchan,
+                                      const float *samples, int count,
+                                      struct demodulator_state_s *D);
+
+    struct my_fsk_queue_s;
+
+    int my_fsk_queue_count(const struct my_fsk_queue_s *q);
+    int my_fsk_queue_get_bits(struct my_fsk_queue_s *q, int *out_bits, int max_bits);
+    int my_fsk_queue_get_words(struct my_fsk_queue_s *q, uint64_t *out, int max_bits);
+    int my_fsk_queue_get_bytes(struct my_fsk_queue_s *q, uint8_t *out, int max_bits);
+    void my_fsk_queue_clear(struct my_fsk_queue_s *q);
+
+    struct my_fsk_queue_s *demod_afsk_queue(struct demodulator_state_s *D, int slicer);
+    void demod_afsk_clear_bits(struct demodulator_state_s *D);
+
+    int demod_afsk_set_slicer(struct demodulator_state_s *D, int slicer,
+                              float threshold, float locked_inertia,
+                              float searching_inertia);
+
+    struct demod_multi_s;
+    struct demod_afsk_opts_s;
+
+    struct demod_multi_s *demod_multi_create(int num_chans,
+                                             int samples_per_sec, int baud,
+                                             int mark_freq, int space_freq,
+                                             char profile,
+                                             const struct demod_afsk_opts_s *opts);
+    void demod_multi_free(struct demod_multi_s *M);
+    int demod_multi_num_chans(const struct demod_multi_s *M);
+    struct my_fsk_queue_s *demod_multi_queue(struct demod_multi_s *M, int chan);
+    void demod_multi_process_s16(struct demod_multi_s *M,
+                                 const int16_t *frames, int count);
+    void demod_multi_process_f32(struct demod_multi_s *M,
+                                 const float *frames, int count);
+
+    struct demod_sched_s;
+
+    struct demod_sched_stats_s {
+        int cpu;
+        int channels;
+        long blocks;
+        long samples;
+        double busy_sec;
+        double wall_sec;
+        double utilization;
+    };
+
+    struct demod_sched_s *demod_sched_create(int num_workers, int pin, int max_chans);
+    void demod_sched_free(struct demod_sched_s *S);
+    int demod_sched_num_workers(const struct demod_sched_s *S);
+    int demod_sched_add(struct demod_sched_s *S, int chan,
+                        struct demodulator_state_s *D);
+    void demod_sched_process_s16(struct demod_sched_s *S,
+                                 const int16_t *const *blocks,
+                                 const int *counts);
+    void demod_sched_process_f32(struct demod_sched_s *S,
+                                 const float *const *blocks,
+                                 const int *counts);
+    void demod_sched_get_stats(const struct demod_sched_s *S, int worker,
+                               struct demod_sched_stats_s *stats);
+    void demod_sched_reset_stats(struct demod_sched_s *S);
+
+    struct demodulator_state_s *create_demodulator_state(void);
+    void free_demodulator_state(struct demodulator_state_s *p);
+
+    struct demod_pool_s;
+
+    #define DEMOD_POOL_HUGEPAGES 1
+
+    struct demod_pool_s *demod_pool_create(int count,
+                                           int samples_per_sec, int baud,
+                                           int mark_freq, int space_freq,
+                                           char profile,
+                                           const struct demod_afsk_opts_s *opts,
+                                           int flags);
+    void demod_pool_free(struct demod_pool_s *P);
+    struct demodulator_state_s *demod_pool_get(struct demod_pool_s *P);
+    void demod_pool_put(struct demod_pool_s *P, struct demodulator_state_s *D);
+    int demod_pool_available(struct demod_pool_s *P);
+    size_t demod_pool_slot_size(const struct demod_pool_s *P);
+    int demod_pool_hugepages(const struct demod_pool_s *P);
 """)
 
 ffibuilder.set_source(
@@ -36,16 +118,25 @@ ffibuilder.set_source(
     #include "viperwolf.h"
     #include "demod_afsk.h"
     #include "my_fsk.h"
+    #include "demod_multi.h"
+    #include "demod_sched.h"
+    #include "demod_factory.h"
     ''',
     sources=[
         # Build the c files needed:
         str(CURRENT_DIR / "c" / "demod_afsk.c"),
+        str(CURRENT_DIR / "c" / "demod_multi.c"),
+        str(CURRENT_DIR / "c" / "demod_sched.c"),
+        str(CURRENT_DIR / "c" / "convolve.c"),
         str(CURRENT_DIR / "c" / "my_fsk.c"),
         str(CURRENT_DIR / "c" / "dsp.c"),
+        str(CURRENT_DIR / "c" / "fft.c"),
+        str(CURRENT_DIR / "c" / "nco.c"),
         str(CURRENT_DIR / "c" / "textcolor.c"),
         str(CURRENT_DIR / "c" / "demod_factory.c"),
     ],
-    include_dirs=[str(CURRENT_DIR / "c" / "include")]
+    include_dirs=[str(CURRENT_DIR / "c" / "include")],
+    libraries=["pthread"]
 )
 
 if __name__ == "__main__":
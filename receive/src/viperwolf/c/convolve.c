@@ -0,0 +1,102 @@
+// File: receive/src/viperwolf/c/convolve.c
+//
+// FIR dot-product kernels for demod_afsk.c, one per instruction set.
+// The kernels themselves are in convolve_kernels.h; the SIMD variants are
+// compiled with per-function target attributes so the extension builds
+// with default compiler flags. Which one runs is decided at run time from
+// CPUID (x86) or HWCAP (ARM).
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "convolve.h"
+#include "convolve_kernels.h"
+#include "textcolor.h"
+
+#if defined(CONVOLVE_NEON) && defined(__linux__)
+  #include <sys/auxv.h>
+  #include <asm/hwcap.h>
+#endif
+
+#define CONVOLVE_HALF_OPS(fmt,isa) {                                          \
+    .pack=pack_##fmt##_##isa, .dot=dot_##fmt##_##isa,                         \
+    .dot2=dot2_##fmt##_##isa, .dot4=dot4_##fmt##_##isa }
+
+#define CONVOLVE_OPS(isa,ols_min,ols_max) {                                   \
+    .name=#isa,                                                               \
+    .dot=dot_##isa,         .dot2=dot2_##isa,         .dot4=dot4_##isa,       \
+    .dot_sym=dot_sym_##isa, .dot2_sym=dot2_sym_##isa, .dot4_sym=dot4_sym_##isa, \
+    .dot_q15=dot_q15_##isa, .dotn=dotn_##isa,     .dotn_sym=dotn_sym_##isa, \
+    .f16=CONVOLVE_HALF_OPS(f16,isa), .bf16=CONVOLVE_HALF_OPS(bf16,isa),       \
+    .ols_min_taps=ols_min, .ols_max_taps=ols_max }
+
+// Break-evens measured from 31 to 4095 taps, whole demodulator on
+// 1024-sample blocks. The generic AVX dot_sym carries a fixed cost that
+// the FFT undercuts from 63 taps on. Past 1024 taps the transform no
+// longer fits next to the demodulator state, and AVX-512 gets ahead again.
+static const struct convolve_ops_s ops_scalar = CONVOLVE_OPS(scalar,96,0);
+#ifdef CONVOLVE_X86
+static const struct convolve_ops_s ops_sse2   = CONVOLVE_OPS(sse2,320,0);
+static const struct convolve_ops_s ops_avx2   = CONVOLVE_OPS(avx2,64,0);
+static const struct convolve_ops_s ops_avx512 = CONVOLVE_OPS(avx512,64,1024);
+#endif
+#ifdef CONVOLVE_NEON
+static const struct convolve_ops_s ops_neon   = CONVOLVE_OPS(neon,320,0);
+#endif
+
+// Kernel sets this CPU can run, best first. Scalar is always last.
+static int convolve_supported(const struct convolve_ops_s **list)
+{
+    int n=0;
+#ifdef CONVOLVE_X86
+    __builtin_cpu_init();
+    // F16C (for the half-precision kernels) came a generation before AVX2.
+    // The AVX-512 set reuses the AVX2 Q15 and F16C half kernels, so it
+    // needs all of them too.
+    int avx2=__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+             __builtin_cpu_supports("f16c");
+    if(avx2 && __builtin_cpu_supports("avx512f")) list[n++]=&ops_avx512;
+    if(avx2) list[n++]=&ops_avx2;
+    if(__builtin_cpu_supports("sse2")) list[n++]=&ops_sse2;
+#endif
+#ifdef CONVOLVE_NEON
+  #if defined(__linux__) && defined(__aarch64__)
+    if(getauxval(AT_HWCAP) & HWCAP_ASIMD) list[n++]=&ops_neon;
+  #elif defined(__linux__) && defined(HWCAP_NEON)
+    if(getauxval(AT_HWCAP) & HWCAP_NEON) list[n++]=&ops_neon;
+  #else
+    list[n++]=&ops_neon;
+  #endif
+#endif
+    list[n++]=&ops_scalar;
+    return n;
+}
+
+static const struct convolve_ops_s *selected_ops;
+static pthread_once_t select_once=PTHREAD_ONCE_INIT;
+
+static void select_ops(void)
+{
+    const struct convolve_ops_s *list[8];
+    int n=convolve_supported(list);
+    const struct convolve_ops_s *ops=list[0];
+
+    char *e=getenv("TUNE_SIMD");
+    if(e){
+        int found=0;
+        for(int i=0;i<n;i++){
+            if(strcmp(e,list[i]->name)==0){ ops=list[i]; found=1; }
+        }
+        text_color_set(DW_COLOR_ERROR);
+        if(found) dw_printf("TUNE: simd = %s\n",ops->name);
+        else      dw_printf("TUNE: simd = %s not supported here, using %s\n",e,ops->name);
+    }
+    selected_ops=ops;
+}
+
+// Decided once per process, so every thread gets the same kernels.
+const struct convolve_ops_s *convolve_select(void)
+{
+    pthread_once(&select_once,select_ops);
+    return selected_ops;
+}
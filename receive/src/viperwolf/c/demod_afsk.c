@@ -1,15 +1,22 @@
 // File: receive/src/direwolf/c/demod_afsk.c
 //
-// Minimal single-slicer AFSK code that calls my_fsk_rec_bit(...).
+// Minimal AFSK code that hands each slicer's bits to its queue, D->bits[slicer].
 
 #include "demod_afsk.h"
 #include "audio.h"
+#include "convolve.h"
+#include "convolve_kernels.h"
 #include "fsk_demod_state.h"
 #include "fsk_gen_filter.h"
-#include "my_fsk.h"     // ring buffer for raw bits
+#include "my_fsk.h"     // queues for raw bits
 #include "textcolor.h"
 #include "viperwolf.h"
 #include "dsp.h"
+#include "fft.h"
+#include "nco.h"
+#include <pthread.h>
+
+extern char **environ;
 
 #define MIN(a,b) ((a)<(b)?(a):(b))
 #define MAX(a,b) ((a)>(b)?(a):(b))
@@ -20,16 +27,79 @@
        dw_printf("TUNE: " name " = " fmt "\n",param); \
     } }
 
-// We'll keep a small cos table for mixing:
-static float fcos256_table[256];
+// Lowest samples per symbol the decimating path will go down to.
+#define DECIMATE_MIN_SPS 16
+
+// Samples staged per pass of the block path. Also the most overlap-save
+// gets per transform, so filters past BLOCK_CHUNK/2 taps pay for a larger
+// FFT than their output needs.
+#define BLOCK_CHUNK 1024
+
+// Stages that take their FIR kernels and tap counts as arguments, so the
+// specialized chunk functions below get them as constants.
+#define DEMOD_INLINE static inline __attribute__((always_inline))
+
+// Fixed-point path: AGC levels carry this many fraction bits.
+#define AGC_Q_FRAC 12
+
+// Threshold spacing of the default slicers, on the demodulator output
+// (+/-1 at the tones).
+#define SLICER_STEP 0.05f
+
+// Profile C: time constant of the detector weights, in symbols.
+#define COMBINE_SYMBOLS 32.f
+
+// IIR prefilter: lowpass prototype order (biquads; twice as many poles)
+// and the Chebyshev passband ripple.
+#define IIR_PREFILTER_SECTIONS 3
+#define IIR_PREFILTER_RIPPLE_DB 0.5f
+
+// Spec-sized filters (opts.filter_design): passband ripple, peak to peak.
+// Kept small; ripple between the tones unbalances mark and space.
+#define FILTER_RIPPLE_DB 0.5f
+
+// Alignment of the state and of each of its arrays: a cache line.
+#define STATE_ALIGN 64
+#define STATE_ROUND(n) (((n)+STATE_ALIGN-1)&~(size_t)(STATE_ALIGN-1))
+#define STATE_HEADER STATE_ROUND(sizeof(struct demodulator_state_s))
+
+// What demod_afsk_setup() does with the arrays once their sizes are known.
+enum setup_mode_e {
+    SETUP_ALLOC,    // allocate them, D->owned
+    SETUP_PLACE,    // in the caller's block, if it is big enough
+    SETUP_SIZE,     // nothing, only report the size
+    SETUP_CONFIG    // nothing, but keep the settings and the filters
+};
+
+// Profile G: pole radius of the sliding DFT. Rounding errors in the
+// recursion die out over about 1/(1-r) samples instead of piling up.
+#define SDFT_DAMPING 0.9999
 
 static inline float fast_hypot(float x, float y){ return hypotf(x,y); }
-static inline void push_sample(float v, float *buf, int size){
-    memmove(buf+1, buf, (size-1)*sizeof(float));
-    buf[0]=v;
+
+static inline void push_sample(float v, struct delay_line_s *dl, int size){
+    dl->pos=(dl->pos>0)?dl->pos-1:size-1;
+    dl->buf[dl->pos]=v;
+    dl->buf[dl->pos+size]=v;
+}
+static inline const float *window_of(const struct delay_line_s *dl){
+    return dl->buf+dl->pos;
 }
-static inline float convolve(const float *data,const float *filt,int taps){
-    float s=0; for(int i=0;i<taps;i++){ s+=data[i]*filt[i]; } return s;
+static inline void push_sample2(float a, float b, struct delay_line2_s *dl, int size){
+    dl->pos=(dl->pos>0)?dl->pos-1:size-1;
+    float *p=dl->buf+2*dl->pos, *q=p+2*size;
+    p[0]=q[0]=a; p[1]=q[1]=b;
+}
+static inline const float *window2_of(const struct delay_line2_s *dl){
+    return dl->buf+2*dl->pos;
+}
+static inline void push_sample4(float a, float b, float c, float d, struct delay_line4_s *dl, int size){
+    dl->pos=(dl->pos>0)?dl->pos-1:size-1;
+    float *p=dl->buf+4*dl->pos, *q=p+4*size;
+    p[0]=q[0]=a; p[1]=q[1]=b; p[2]=q[2]=c; p[3]=q[3]=d;
+}
+static inline const float *window4_of(const struct delay_line4_s *dl){
+    return dl->buf+4*dl->pos;
 }
 
 // AGC:
@@ -51,17 +121,207 @@ static inline float agc(float in, float fa, float sd, float *ppeak,float *pval)
 }
 
 // forward decl
-static void nudge_pll(int chan,int subchan,float demod_out,
+static void nudge_pll(int chan,int subchan,const float *demod_out,
                       struct demodulator_state_s*D,float amplitude);
+static void nudge_pll_q15(int chan,int subchan,int32_t demod_out,
+                          struct demodulator_state_s*D);
+static demod_chunk_fn demod_afsk_bind_chunk(const struct demodulator_state_s*D,int pre_sym,int lp_sym,int allow_spec);
+static int is_specialized(demod_chunk_fn fn);
 
-void demod_afsk_init(int sps,int baud,int mf,int sf,char prof,struct demodulator_state_s*D)
+// Load sections from gen_iir_bandpass(); the rest pass samples through.
+static void iir_init(struct iir_cascade_s *c,const struct biquad_s *sos,int n)
+{
+    memset(c,0,sizeof(*c));
+    c->sections=n;
+    for(int k=0;k<IIR_MAX_SECTIONS;k++){
+        c->b0[k]=(k<n)?sos[k].b0:1.f;
+        if(k>=n) continue;
+        c->b1[k]=sos[k].b1; c->b2[k]=sos[k].b2;
+        c->a1[k]=sos[k].a1; c->a2[k]=sos[k].a2;
+    }
+}
+
+// Decision threshold and inertias of one slicer, for both paths. The
+// fixed-point demod_out is Q15 (+/-16384 for +/-0.5) for profile A and the
+// binary-angle phase step for B.
+static void slicer_config(struct demodulator_state_s*D,int i,float threshold,float locked,float searching)
+{
+    D->slicer[i].threshold=threshold;
+    D->slicer[i].locked_inertia=locked;
+    D->slicer[i].searching_inertia=searching;
+
+    double q_scale=32768.;
+    if((D->profile=='B'||D->profile=='D') && D->u.afsk.normalize_rpsam>0.f){
+        q_scale=65536./(2.*M_PI*D->u.afsk.normalize_rpsam);
+    }
+    D->slicer[i].q_threshold=(int32_t)lrint(threshold*q_scale);
+    D->slicer[i].q_locked_inertia=(int32_t)lrint(locked*65536.);
+    D->slicer[i].q_searching_inertia=(int32_t)lrint(searching*65536.);
+}
+
+void demod_afsk_default_opts(struct demod_afsk_opts_s *opts)
 {
-    for(int i=0;i<256;i++){
-        fcos256_table[i]=cosf( (float)i * 2.f*(float)M_PI/256.f );
+    memset(opts,0,sizeof(*opts));
+    opts->decimate=1;
+    opts->num_slicers=1;
+    opts->filter_atten_db=30.f;
+
+    TUNE("TUNE_DECIMATE",opts->decimate,"decimate","%d")
+    TUNE("TUNE_FAST_CONV",opts->fast_conv,"fast_conv","%d")
+    TUNE("TUNE_FIXED_POINT",opts->fixed_point,"fixed_point","%d")
+    TUNE("TUNE_FM_DISC",opts->fm_disc,"fm_disc","%d")
+    TUNE("TUNE_SPECIALIZE",opts->specialize,"specialize","%d")
+    TUNE("TUNE_PREFILTER_IIR",opts->prefilter_iir,"prefilter_iir","%d")
+    TUNE("TUNE_NUM_SLICERS",opts->num_slicers,"num_slicers","%d")
+    TUNE("TUNE_FILTER_DESIGN",opts->filter_design,"filter_design","%d")
+    TUNE("TUNE_FILTER_ATTEN",opts->filter_atten_db,"filter_atten_db","%.1f")
+    TUNE("TUNE_LOW_LATENCY",opts->low_latency,"low_latency","%d")
+    TUNE("TUNE_HALF_STORAGE",opts->half_storage,"half_storage","%d")
+}
+
+static void out_of_memory(void)
+{
+    text_color_set(DW_COLOR_ERROR);
+    dw_printf("Demodulator init: out of memory\n");
+    exit(1);
+}
+
+// Next array of 'bytes' at *off from 'base', keeping STATE_ALIGN. With
+// base NULL only the offset moves.
+static void *carve(char *base,size_t *off,size_t bytes)
+{
+    void *p=base?base+*off:NULL;
+    *off+=STATE_ROUND(bytes);
+    return p;
+}
+
+// Point the per-instance arrays of D into 'base' (NULL: only measure) and
+// return how many bytes they take: the bit queues (num_queues, placed first
+// so demod_afsk_set_slicer() can add more), then the delay lines of
+// the path and profile in use, each as long as its filter and no longer,
+// and the overlap-save work buffer. The filters and the overlap-save
+// spectrum are in D->coef.
+static size_t demod_afsk_layout(struct demodulator_state_s*D,char *base)
+{
+    char prof=D->profile;
+    int pre=D->pre_filter_taps, lp=D->lp_filter_taps;
+    int use_a=(prof=='A'||prof=='E'||prof=='C');
+    int use_b=(prof=='B'||prof=='D'||prof=='C');
+    size_t off=0;
+
+    D->arrays=base;
+    D->bits=carve(base,&off,D->num_queues*sizeof(struct my_fsk_queue_s));
+    if(D->fixed){
+        D->q.raw_cb.buf=carve(base,&off,2*pre*sizeof(int16_t));
+        for(int j=0;j<(use_a?4:2);j++) D->q.IQ_raw.buf[j]=carve(base,&off,2*lp*sizeof(int16_t));
+        return off;
+    }
+
+    size_t sample=D->half?sizeof(uint16_t):sizeof(float);
+    if(prof=='G') D->raw_cb.buf=carve(base,&off,2*(D->u.afsk.sdft_len+1)*sizeof(float));
+    else if(D->use_prefilter && !D->use_iir) D->raw_cb.buf=carve(base,&off,2*pre*sample);
+    if(use_a) D->u.afsk.ms_IQ_raw.buf=carve(base,&off,2*lp*4*sample);
+    if(use_b) D->u.afsk.c_IQ_raw.buf=carve(base,&off,2*lp*2*sample);
+    if(D->use_ols) D->ols_work=carve(base,&off,ols_work_size(D->pre_ols));
+    return off;
+}
+
+// Coefficient cache: designed filters and the state fresh from the design
+// (the template), shared by all instances initialized with the same key.
+// Entries are freed with their last reference.
+struct coef_key_s {
+    int sps, baud, mf, sf;
+    char prof;
+    struct demod_afsk_opts_s opts;
+    char *tune;             // the TUNE_* environment, "NAME=value\n"...
+};
+
+struct coef_set_s {
+    struct coef_set_s *next;
+    int refs;
+    struct coef_key_s key;
+    struct demodulator_state_s tmpl;
+    struct ols_s pre_ols;   // tmpl.pre_ols, if it uses one
+    // filters follow, STATE_ALIGN aligned, then the overlap-save spectrum
+};
+
+static pthread_mutex_t coef_lock=PTHREAD_MUTEX_INITIALIZER;
+static struct coef_set_s *coef_list;
+
+static void coef_key_init(struct coef_key_s *k,int sps,int baud,int mf,int sf,char prof,const struct demod_afsk_opts_s *opts)
+{
+    size_t len=1;
+    for(char **e=environ;*e;e++) if(strncmp(*e,"TUNE_",5)==0) len+=strlen(*e)+1;
+    k->tune=malloc(len);
+    if(!k->tune) out_of_memory();
+    k->tune[0]=0;
+    for(char **e=environ;*e;e++){
+        if(strncmp(*e,"TUNE_",5)==0){
+            strcat(k->tune,*e);
+            strcat(k->tune,"\n");
+        }
     }
+    k->sps=sps; k->baud=baud; k->mf=mf; k->sf=sf;
+    k->prof=prof;
+    k->opts=*opts;
+}
+
+static int coef_key_equal(const struct coef_key_s *a,const struct coef_key_s *b)
+{
+    return a->sps==b->sps && a->baud==b->baud && a->mf==b->mf && a->sf==b->sf && a->prof==b->prof &&
+           memcmp(&a->opts,&b->opts,sizeof(a->opts))==0 && strcmp(a->tune,b->tune)==0;
+}
+
+// Referenced entry for k, or NULL. Caller holds coef_lock.
+static struct coef_set_s *coef_find(const struct coef_key_s *k)
+{
+    for(struct coef_set_s *c=coef_list;c;c=c->next){
+        if(coef_key_equal(&c->key,k)){
+            c->refs++;
+            return c;
+        }
+    }
+    return NULL;
+}
+
+static void coef_release(struct coef_set_s *c)
+{
+    if(!c) return;
+    pthread_mutex_lock(&coef_lock);
+    if(--c->refs==0){
+        struct coef_set_s **pp=&coef_list;
+        while(*pp!=c) pp=&(*pp)->next;
+        *pp=c->next;
+    } else {
+        c=NULL;
+    }
+    pthread_mutex_unlock(&coef_lock);
+    if(c){
+        free(c->key.tune);
+        free(c);
+    }
+}
+
+// Design the filters and everything else fixed by the key into a new
+// coefficient set, with one reference. The filters go to scratch first,
+// since their lengths are only known afterwards.
+static struct coef_set_s *demod_afsk_design(int sps,int baud,int mf,int sf,char prof,
+                                            const struct demod_afsk_opts_s *opts)
+{
+    struct demodulator_state_s tmpl, *D=&tmpl;
     memset(D,0,sizeof(*D));
     D->num_slicers=1;
     D->profile=prof;
+    D->fixed=(opts->fixed_point!=0);
+    D->fir=convolve_select();
+
+    float *scratch=calloc(4*MAX_FILTER_SIZE,sizeof(float));
+    if(!scratch) out_of_memory();
+    D->pre_filter=scratch;
+    D->lp_filter=scratch+MAX_FILTER_SIZE;
+    D->u.afsk.c_lp_filter=scratch+2*MAX_FILTER_SIZE;
+    D->q.pre_filter=(int16_t *)(scratch+3*MAX_FILTER_SIZE);
+    D->q.lp_filter=D->q.pre_filter+MAX_FILTER_SIZE;
 
     TUNE("TUNE_USE_RRC",D->u.afsk.use_rrc,"use_rrc","%d")
 
@@ -72,6 +332,7 @@ void demod_afsk_init(int sps,int baud,int mf,int sf,char prof,struct demodulator
         D->prefilter_baud=(baud>600)?0.155f:0.87f;
         D->pre_filter_len_sym=(baud>600)?(383*1200.f/44100.f):1.857f;
         D->pre_window=BP_WINDOW_TRUNCATED;
+        D->pre_trans_baud=(baud>600)?0.4f:1.6f;
 
         D->u.afsk.m_osc_phase=0;
         D->u.afsk.m_osc_delta=(unsigned int)round(pow(2.,32.)*(double)mf/(double)sps);
@@ -85,6 +346,7 @@ void demod_afsk_init(int sps,int baud,int mf,int sf,char prof,struct demodulator
 
         D->lpf_baud=0.14f;
         D->lp_filter_width_sym=1.388f;
+        D->lp_trans_baud=1.0f;
 
         D->agc_fast_attack=0.70f;
         D->agc_slow_decay=0.000090f;
@@ -98,6 +360,7 @@ void demod_afsk_init(int sps,int baud,int mf,int sf,char prof,struct demodulator
         D->prefilter_baud=(baud>600)?0.19f:0.87f;
         D->pre_filter_len_sym=(baud>600)?8.163f:1.857f;
         D->pre_window=BP_WINDOW_TRUNCATED;
+        D->pre_trans_baud=(baud>600)?0.4f:1.6f;
 
         D->u.afsk.c_osc_phase=0;
         D->u.afsk.c_osc_delta=(unsigned int)round(pow(2.,32.)*0.5*(mf+sf)/(double)sps);
@@ -108,8 +371,10 @@ void demod_afsk_init(int sps,int baud,int mf,int sf,char prof,struct demodulator
 
         D->lpf_baud=0.50f;
         D->lp_filter_width_sym=1.714286f;
+        D->lp_trans_baud=1.0f;
 
         D->u.afsk.normalize_rpsam=1.0f/(0.5f*fabsf((float)mf-(float)sf)*2.f*(float)M_PI/(float)sps);
+        D->u.afsk.fm_disc=opts->fm_disc;
 
         D->agc_fast_attack=0.70f;
         D->agc_slow_decay=0.000090f;
@@ -120,6 +385,67 @@ void demod_afsk_init(int sps,int baud,int mf,int sf,char prof,struct demodulator
         D->alevel_space_peak=-1.f;
       break;
 
+      case 'C':
+        // A and B on one prefilter: A's (the narrower one at 1200 baud),
+        // A's lowpass and AGC for the envelope detector, B's lowpass as
+        // c_lp_filter for the discriminator.
+        D->use_prefilter=1;
+        D->prefilter_baud=(baud>600)?0.155f:0.87f;
+        D->pre_filter_len_sym=(baud>600)?(383*1200.f/44100.f):1.857f;
+        D->pre_window=BP_WINDOW_TRUNCATED;
+        D->pre_trans_baud=(baud>600)?0.4f:1.6f;
+
+        D->u.afsk.m_osc_phase=0;
+        D->u.afsk.m_osc_delta=(unsigned int)round(pow(2.,32.)*(double)mf/(double)sps);
+
+        D->u.afsk.s_osc_phase=0;
+        D->u.afsk.s_osc_delta=(unsigned int)round(pow(2.,32.)*(double)sf/(double)sps);
+
+        D->u.afsk.c_osc_phase=0;
+        D->u.afsk.c_osc_delta=(unsigned int)round(pow(2.,32.)*0.5*(mf+sf)/(double)sps);
+
+        D->u.afsk.use_rrc=1;
+        D->u.afsk.rrc_width_sym=2.80f;
+        D->u.afsk.rrc_rolloff=0.20f;
+        D->u.afsk.c_rrc_width_sym=2.00f;
+        D->u.afsk.c_rrc_rolloff=0.40f;
+
+        D->lpf_baud=0.14f;
+        D->lp_filter_width_sym=1.388f;
+        D->lp_trans_baud=1.0f;
+
+        D->u.afsk.normalize_rpsam=1.0f/(0.5f*fabsf((float)mf-(float)sf)*2.f*(float)M_PI/(float)sps);
+        D->u.afsk.fm_disc=opts->fm_disc;
+
+        D->agc_fast_attack=0.70f;
+        D->agc_slow_decay=0.000090f;
+        D->pll_locked_inertia=0.74f;
+        D->pll_searching_inertia=0.50f;
+
+        if(D->fixed){
+            text_color_set(DW_COLOR_ERROR);
+            dw_printf("Profile C has no fixed-point path, using float.\n");
+            D->fixed=0;
+        }
+      break;
+
+      case 'G':
+        // Sliding DFT bins at the tones over one symbol, see
+        // chunk_g_generic(). The window is the only filter.
+        D->use_prefilter=0;
+
+        D->agc_fast_attack=0.70f;
+        D->agc_slow_decay=0.000090f;
+        D->pll_locked_inertia=0.74f;
+        D->pll_searching_inertia=0.50f;
+
+        if(D->fixed){
+            text_color_set(DW_COLOR_ERROR);
+            dw_printf("Profile G has no fixed-point path, using float.\n");
+            D->fixed=0;
+        }
+      break;
+
       default:
         text_color_set(DW_COLOR_ERROR);
         dw_printf("Invalid profile=%c\n",prof);
@@ -127,27 +453,89 @@ void demod_afsk_init(int sps,int baud,int mf,int sf,char prof,struct demodulator
     }
 
     TUNE("TUNE_PRE_BAUD",D->prefilter_baud,"prefilter_baud","%.3f")
+    TUNE("TUNE_PRE_TRANS",D->pre_trans_baud,"pre_trans_baud","%.3f")
+    TUNE("TUNE_LP_TRANS",D->lp_trans_baud,"lp_trans_baud","%.3f")
+    TUNE("TUNE_PRE_WINDOW",D->pre_window,"pre_window","%d")
 
-    if(baud==521){
-        D->pll_step_per_sample=(int)round((TICKS_PER_PLL_CYCLE*520.83)/(double)sps);
-    } else {
-        D->pll_step_per_sample=(int)round((TICKS_PER_PLL_CYCLE*(double)baud)/(double)sps);
+    // Decimation: the lowpass output, AGC and PLL only run every Nth
+    // sample. Keep at least DECIMATE_MIN_SPS samples per symbol.
+    int max_decimate=sps/(baud*DECIMATE_MIN_SPS);
+    if(max_decimate<1) max_decimate=1;
+    D->decimate=(opts->decimate==0)?max_decimate:MIN(MAX(opts->decimate,1),max_decimate);
+    D->decim_count=1;
+
+    double sym_rate=(baud==521)?520.83:(double)baud;
+    D->pll_step_per_sample=(int)round((TICKS_PER_PLL_CYCLE*sym_rate*D->decimate)/(double)sps);
+
+    if(prof=='G'){
+        // S[n] = r*e^(jw)*S[n-1] + x[n] - r^N*e^(jwN)*x[n-N], N about one
+        // symbol. Where a whole number of cycles of the tone difference
+        // fits within a quarter symbol of that, take it instead: then each
+        // tone sits in a null of the other's bin. With Bell 202 at 44.1 kHz
+        // that is 44 samples rather than 37, and cuts bit errors several
+        // times over at low SNR.
+        double sym=(double)sps/sym_rate;
+        double cyc=(double)sps/fabs((double)mf-(double)sf);
+        double k=MAX(round(sym/cyc),1.);
+        int n=(int)lrint((fabs(k*cyc-sym)<=0.25*sym)?k*cyc:sym);
+        n=MIN(MAX(n,2),MAX_FILTER_SIZE-1);
+        D->u.afsk.sdft_len=n;
+        double tone[2]={ (double)mf, (double)sf };
+        for(int k=0;k<2;k++){
+            double w=2.*M_PI*tone[k]/(double)sps;
+            double rn=pow(SDFT_DAMPING,(double)n);
+            D->u.afsk.sdft_rot[k][0]=(float)(SDFT_DAMPING*cos(w));
+            D->u.afsk.sdft_rot[k][1]=(float)(SDFT_DAMPING*sin(w));
+            D->u.afsk.sdft_tail[k][0]=(float)(rn*cos(w*n));
+            D->u.afsk.sdft_tail[k][1]=(float)(rn*sin(w*n));
+        }
+    }
+
+    if(D->decimate>1){
+        // Same time constants at the reduced rate.
+        D->agc_fast_attack=1.f-powf(1.f-D->agc_fast_attack,(float)D->decimate);
+        D->agc_slow_decay=1.f-powf(1.f-D->agc_slow_decay,(float)D->decimate);
+        D->u.afsk.normalize_rpsam/=(float)D->decimate;
     }
 
     if(D->use_prefilter){
-        D->pre_filter_taps=(int)(D->pre_filter_len_sym*(float)sps/(float)baud);
-        D->pre_filter_taps|=1;
-        if(D->pre_filter_taps<1) D->pre_filter_taps=1;
-        if(D->pre_filter_taps>MAX_FILTER_SIZE){
-            D->pre_filter_taps=(MAX_FILTER_SIZE-1)|1;
-        }
         float f1=MIN(mf,sf)-D->prefilter_baud*baud;
         float f2=MAX(mf,sf)+D->prefilter_baud*baud;
         f1/=(float)sps;f2/=(float)sps;
-        gen_bandpass(f1,f2,D->pre_filter,D->pre_filter_taps,D->pre_window);
+        if(opts->filter_design!=FILTER_DESIGN_FIXED){
+            // As short as the spec allows, instead of pre_filter_len_sym.
+            struct filter_spec_s spec={ D->pre_trans_baud*baud/(float)sps,opts->filter_atten_db,FILTER_RIPPLE_DB };
+            D->pre_filter_taps=gen_bandpass_spec(f1,f2,&spec,opts->filter_design,D->pre_filter,MAX_FILTER_SIZE);
+        } else {
+            D->pre_filter_taps=(int)(D->pre_filter_len_sym*(float)sps/(float)baud);
+            D->pre_filter_taps|=1;
+            if(D->pre_filter_taps<1) D->pre_filter_taps=1;
+            if(D->pre_filter_taps>MAX_FILTER_SIZE){
+                D->pre_filter_taps=(MAX_FILTER_SIZE-1)|1;
+            }
+            gen_bandpass(f1,f2,D->pre_filter,D->pre_filter_taps,D->pre_window);
+        }
+
+        // Same band edges as a biquad cascade. The fixed-point path keeps
+        // the FIR.
+        if(opts->prefilter_iir!=IIR_NONE && !D->fixed){
+            struct biquad_s sos[IIR_MAX_SECTIONS];
+            int n=gen_iir_bandpass(f1,f2,IIR_PREFILTER_SECTIONS,(iir_type_t)opts->prefilter_iir,
+                                   IIR_PREFILTER_RIPPLE_DB,sos);
+            if(n>0){
+                iir_init(&D->pre_iir,sos,n);
+                D->use_iir=1;
+            } else {
+                text_color_set(DW_COLOR_ERROR);
+                dw_printf("IIR prefilter: cannot design %.0f-%.0f Hz, using the FIR.\n",f1*sps,f2*sps);
+            }
+        }
     }
 
-    if(D->u.afsk.use_rrc){
+    if(prof=='G'){
+        // No lowpass: the SDFT window is the filter.
+        D->lp_filter_taps=0;
+    } else if(D->u.afsk.use_rrc){
         D->lp_filter_taps=(int)(D->u.afsk.rrc_width_sym*(float)sps/(float)baud);
         D->lp_filter_taps|=1;
         if(D->lp_filter_taps<9) D->lp_filter_taps=9;
@@ -158,6 +546,10 @@ void demod_afsk_init(int sps,int baud,int mf,int sf,char prof,struct demodulator
                         D->lp_filter_taps,
                         D->u.afsk.rrc_rolloff,
                         (float)sps/(float)baud);
+    } else if(opts->filter_design!=FILTER_DESIGN_FIXED){
+        float fc=baud*D->lpf_baud/(float)sps;
+        struct filter_spec_s spec={ D->lp_trans_baud*baud/(float)sps,opts->filter_atten_db,FILTER_RIPPLE_DB };
+        D->lp_filter_taps=gen_lowpass_spec(fc,&spec,opts->filter_design,D->lp_filter,MAX_FILTER_SIZE);
     } else {
         D->lp_filter_taps=(int)round(D->lp_filter_width_sym*(float)sps/(float)baud);
         if(D->lp_filter_taps<9) D->lp_filter_taps=9;
@@ -167,105 +559,1041 @@ void demod_afsk_init(int sps,int baud,int mf,int sf,char prof,struct demodulator
         float fc=baud*D->lpf_baud/(float)sps;
         gen_lowpass(fc,D->lp_filter,D->lp_filter_taps,D->lp_window);
     }
+
+    // Profile C: B's lowpass runs on the middle c_lp_filter_taps of the
+    // c_IQ_raw window (which is as long as lp_filter), so both detectors
+    // have the same delay and their outputs line up.
+    if(prof=='C'){
+        int c_taps=(int)(D->u.afsk.c_rrc_width_sym*(float)sps/(float)baud);
+        c_taps|=1;
+        if(c_taps<9) c_taps=9;
+        if(c_taps>D->lp_filter_taps) c_taps=D->lp_filter_taps;
+        D->u.afsk.c_lp_filter_taps=c_taps;
+        D->u.afsk.c_lp_offset=(D->lp_filter_taps-c_taps)/2;
+        gen_rrc_lowpass(D->u.afsk.c_lp_filter,
+                        c_taps,
+                        D->u.afsk.c_rrc_rolloff,
+                        (float)sps/(float)baud);
+
+        // Detector weights follow about COMBINE_SYMBOLS symbols.
+        D->u.afsk.combine_alpha=1.f-expf(-(float)(baud*D->decimate)/((float)sps*COMBINE_SYMBOLS));
+    }
+
+    // Low latency: trade the linear phase for minimum phase. The delay of
+    // each filter drops from (taps-1)/2 to what its band edges need.
+    // make_min_phase() only fails for lack of memory.
+    if(opts->low_latency){
+        if(D->use_prefilter && !make_min_phase(D->pre_filter,D->pre_filter_taps)) out_of_memory();
+        if(D->lp_filter_taps && !make_min_phase(D->lp_filter,D->lp_filter_taps)) out_of_memory();
+        if(prof=='C'){
+            if(!make_min_phase(D->u.afsk.c_lp_filter,D->u.afsk.c_lp_filter_taps)) out_of_memory();
+            D->u.afsk.c_lp_offset=0;
+        }
+    }
+
+    // 16-bit delay lines: only the plain kernels exist in those formats.
+    if(opts->half_storage!=HALF_STORAGE_NONE && !D->fixed && prof!='G'){
+        D->half=(opts->half_storage==HALF_STORAGE_BF16)?&D->fir->bf16:&D->fir->f16;
+    }
+
+    // Linear-phase filters take the folded kernels (half the multiplies).
+    // lp_conv2 runs c_lp_filter in profile C.
+    int pre_sym=is_symmetric(D->pre_filter,D->pre_filter_taps);
+    int lp_sym=is_symmetric(D->lp_filter,D->lp_filter_taps);
+    int lp2_sym=(prof=='C')?is_symmetric(D->u.afsk.c_lp_filter,D->u.afsk.c_lp_filter_taps):lp_sym;
+    D->pre_conv=pre_sym?D->fir->dot_sym:D->fir->dot;
+    D->lp_conv2=lp2_sym?D->fir->dot2_sym:D->fir->dot2;
+    D->lp_conv4=lp_sym?D->fir->dot4_sym:D->fir->dot4;
+    D->process_chunk=demod_afsk_bind_chunk(D,pre_sym,lp_sym,opts->specialize>=0);
+
+    // On request, the prefilter goes through overlap-save on block input:
+    // FAST_CONV_AUTO within the measured break-evens of the selected FIR
+    // kernels. Not with 16-bit storage: its float history is what that
+    // option saves. Nor automatically under a specialization: with the
+    // taps as constants the direct kernels stay ahead at every length in
+    // DEMOD_SPEC_LIST.
+    int want_ols=0;
+    if(D->use_prefilter && !D->use_iir && !D->fixed && !D->half){
+        int taps=D->pre_filter_taps, max=D->fir->ols_max_taps;
+        int in_range=(taps>=D->fir->ols_min_taps && (!max || taps<=max));
+        if(opts->fast_conv==FAST_CONV_ALWAYS) want_ols=1;
+        if(opts->fast_conv==FAST_CONV_AUTO) want_ols=(in_range && !is_specialized(D->process_chunk));
+    }
+
+    // Everything the fixed-point path needs at run time, in integers.
+    if(D->fixed){
+        D->q.pre_shift=quantize_q15(D->pre_filter,D->pre_filter_taps,D->q.pre_filter);
+        D->q.lp_shift=quantize_q15(D->lp_filter,D->lp_filter_taps,D->q.lp_filter);
+        D->q.agc_fast_attack=(int32_t)lrint(D->agc_fast_attack*16777216.);
+        D->q.agc_slow_decay=(int32_t)lrint(D->agc_slow_decay*16777216.);
+    }
+
+    // Slicers: 0 at the center, the rest alternating above and below it.
+    // Profile C first puts 1 and 2 at the center of the A and B outputs.
+    int first=(prof=='C')?DEMOD_OUT_COUNT:1;
+    for(int i=0;i<MAX_SLICERS;i++){
+        int k=(i<first)?0:i-first+1;
+        float threshold=SLICER_STEP*(float)((k+1)/2)*((k&1)?1.f:-1.f);
+        slicer_config(D,i,threshold,D->pll_locked_inertia,D->pll_searching_inertia);
+        D->slicer[i].source=(i<first)?i:DEMOD_OUT_MAIN;
+    }
+    D->num_slicers=MIN(MAX(opts->num_slicers,1),MAX_SLICERS);
+    D->num_queues=D->num_slicers;
+
+    // The set: the template, then the filters it points to.
+    int pre=D->pre_filter_taps, lp=D->lp_filter_taps, c_lp=D->u.afsk.c_lp_filter_taps;
+    size_t off=STATE_ROUND(sizeof(struct coef_set_s)), size=off;
+    size+=STATE_ROUND(pre*sizeof(float))+STATE_ROUND(lp*sizeof(float));
+    if(prof=='C') size+=STATE_ROUND(c_lp*sizeof(float));
+    if(D->fixed) size+=STATE_ROUND(pre*sizeof(int16_t))+STATE_ROUND(lp*sizeof(int16_t));
+    if(want_ols) size+=STATE_ROUND(ols_size(pre));
+
+    struct coef_set_s *c;
+    if(posix_memalign((void **)&c,STATE_ALIGN,size)!=0) out_of_memory();
+    memset(c,0,sizeof(*c));
+    c->refs=1;
+
+    char *base=(char *)c;
+    const int16_t *q=(const int16_t *)(scratch+3*MAX_FILTER_SIZE);
+    D->pre_filter=carve(base,&off,pre*sizeof(float));
+    memcpy(D->pre_filter,scratch,pre*sizeof(float));
+    if(lp){
+        D->lp_filter=carve(base,&off,lp*sizeof(float));
+        memcpy(D->lp_filter,scratch+MAX_FILTER_SIZE,lp*sizeof(float));
+    } else {
+        D->lp_filter=NULL;
+    }
+    if(prof=='C'){
+        D->u.afsk.c_lp_filter=carve(base,&off,c_lp*sizeof(float));
+        memcpy(D->u.afsk.c_lp_filter,scratch+2*MAX_FILTER_SIZE,c_lp*sizeof(float));
+    } else {
+        D->u.afsk.c_lp_filter=NULL;
+    }
+    if(D->fixed){
+        D->q.pre_filter=carve(base,&off,pre*sizeof(int16_t));
+        D->q.lp_filter=carve(base,&off,lp*sizeof(int16_t));
+        memcpy(D->q.pre_filter,q,pre*sizeof(int16_t));
+        memcpy(D->q.lp_filter,q+MAX_FILTER_SIZE,lp*sizeof(int16_t));
+    } else {
+        D->q.pre_filter=NULL;
+        D->q.lp_filter=NULL;
+    }
+    // The transform of the prefilter, for every instance; each has its own
+    // work buffer only.
+    if(want_ols){
+        D->use_ols=ols_init(&c->pre_ols,D->pre_filter,pre,carve(base,&off,ols_size(pre)));
+        D->pre_ols=&c->pre_ols;
+    }
+    free(scratch);
+
+    c->tmpl=*D;
+    return c;
 }
 
-void demod_afsk_process_sample(int chan,int subchan,int sam,struct demodulator_state_s*D)
+// The body of every init: the coefficient set for the key, from the cache
+// or designed, then the instance's own arrays laid out per 'mode'. Returns
+// the bytes those need (in SETUP_PLACE mode, larger than 'size' means
+// nothing was placed and D holds no reference).
+static size_t demod_afsk_setup(int sps,int baud,int mf,int sf,char prof,const struct demod_afsk_opts_s *opts,
+                               struct demodulator_state_s*D,enum setup_mode_e mode,char *mem,size_t size)
 {
-    float fsam=(float)sam/16384.f;
+    nco_init_tables();
 
-    switch(D->profile){
-      case 'A':
-      case 'E': {
-        if(D->use_prefilter){
-            push_sample(fsam,D->raw_cb,D->pre_filter_taps);
-            fsam=convolve(D->raw_cb,D->pre_filter,D->pre_filter_taps);
+    struct coef_key_s key;
+    coef_key_init(&key,sps,baud,mf,sf,prof,opts);
+    pthread_mutex_lock(&coef_lock);
+    struct coef_set_s *c=coef_find(&key);
+    pthread_mutex_unlock(&coef_lock);
+
+    if(!c){
+        // Designed outside the lock; if another thread got there first,
+        // take theirs.
+        struct coef_set_s *fresh=demod_afsk_design(sps,baud,mf,sf,prof,opts);
+        pthread_mutex_lock(&coef_lock);
+        c=coef_find(&key);
+        if(!c){
+            c=fresh;
+            c->key=key;
+            c->next=coef_list;
+            coef_list=c;
+            key.tune=NULL;
+            fresh=NULL;
         }
-        // Mark
-        unsigned int mp=(D->u.afsk.m_osc_phase>>24)&0xff;
-        float cos_m=fcos256_table[mp];
-        float sin_m=fcos256_table[((mp-64)&0xff)];
-
-        push_sample(fsam*cos_m,D->u.afsk.m_I_raw,D->lp_filter_taps);
-        push_sample(fsam*sin_m,D->u.afsk.m_Q_raw,D->lp_filter_taps);
-        D->u.afsk.m_osc_phase += D->u.afsk.m_osc_delta;
-
-        // Space
-        unsigned int sp=(D->u.afsk.s_osc_phase>>24)&0xff;
-        float cos_s=fcos256_table[sp];
-        float sin_s=fcos256_table[((sp-64)&0xff)];
-
-        push_sample(fsam*cos_s,D->u.afsk.s_I_raw,D->lp_filter_taps);
-        push_sample(fsam*sin_s,D->u.afsk.s_Q_raw,D->lp_filter_taps);
-        D->u.afsk.s_osc_phase += D->u.afsk.s_osc_delta;
-
-        float m_I=convolve(D->u.afsk.m_I_raw,D->lp_filter,D->lp_filter_taps);
-        float m_Q=convolve(D->u.afsk.m_Q_raw,D->lp_filter,D->lp_filter_taps);
-        float m_amp=fast_hypot(m_I,m_Q);
-
-        float s_I=convolve(D->u.afsk.s_I_raw,D->lp_filter,D->lp_filter_taps);
-        float s_Q=convolve(D->u.afsk.s_Q_raw,D->lp_filter,D->lp_filter_taps);
-        float s_amp=fast_hypot(s_I,s_Q);
-
-        float m_norm=agc(m_amp,D->agc_fast_attack,D->agc_slow_decay,&D->m_peak,&D->m_valley);
-        float s_norm=agc(s_amp,D->agc_fast_attack,D->agc_slow_decay,&D->s_peak,&D->s_valley);
-        float demod_out=m_norm - s_norm;
-
-        nudge_pll(chan,subchan,demod_out,D,1.0f);
-      }
-      break;
+        pthread_mutex_unlock(&coef_lock);
+        free(fresh);
+    }
+    free(key.tune);
 
-      case 'B':
-      case 'D': {
-        if(D->use_prefilter){
-            push_sample(fsam,D->raw_cb,D->pre_filter_taps);
-            fsam=convolve(D->raw_cb,D->pre_filter,D->pre_filter_taps);
+    *D=c->tmpl;
+    size_t need=demod_afsk_layout(D,NULL);
+    if(mode==SETUP_SIZE || (mode==SETUP_PLACE && need>size)){
+        coef_release(c);
+        memset(D,0,sizeof(*D));
+        return need;
+    }
+    if(mode==SETUP_CONFIG){
+        D->coef=c;      // the array pointers were left NULL
+        return need;
+    }
+    if(mode==SETUP_ALLOC){
+        if(posix_memalign((void **)&mem,STATE_ALIGN,MAX(need,1))!=0) out_of_memory();
+        D->owned=mem;
+    }
+    D->coef=c;
+    memset(mem,0,need);
+    demod_afsk_layout(D,mem);
+    return need;
+}
+
+void demod_afsk_init(int sps,int baud,int mf,int sf,char prof,struct demodulator_state_s*D)
+{
+    struct demod_afsk_opts_s opts;
+    demod_afsk_default_opts(&opts);
+    demod_afsk_init_opts(sps,baud,mf,sf,prof,&opts,D);
+}
+
+void demod_afsk_init_opts(int sps,int baud,int mf,int sf,char prof,
+                          const struct demod_afsk_opts_s *opts,struct demodulator_state_s*D)
+{
+    // Released after the setup, so re-initializing with the same settings
+    // finds the coefficients still cached.
+    struct demodulator_state_s old=*D;
+    demod_afsk_setup(sps,baud,mf,sf,prof,opts,D,SETUP_ALLOC,NULL,0);
+    demod_afsk_release(&old);
+}
+
+void demod_afsk_init_config(int sps,int baud,int mf,int sf,char prof,
+                            const struct demod_afsk_opts_s *opts,struct demodulator_state_s*D)
+{
+    demod_afsk_setup(sps,baud,mf,sf,prof,opts,D,SETUP_CONFIG,NULL,0);
+}
+
+size_t demod_afsk_state_size(int sps,int baud,int mf,int sf,char prof,const struct demod_afsk_opts_s *opts)
+{
+    struct demodulator_state_s D;
+    return STATE_HEADER+demod_afsk_setup(sps,baud,mf,sf,prof,opts,&D,SETUP_SIZE,NULL,0);
+}
+
+struct demodulator_state_s *demod_afsk_init_in(void *mem,size_t size,int sps,int baud,int mf,int sf,char prof,
+                                               const struct demod_afsk_opts_s *opts)
+{
+    if(size<STATE_HEADER || ((uintptr_t)mem&(STATE_ALIGN-1))) return NULL;
+    struct demodulator_state_s *D=mem;
+    size_t avail=size-STATE_HEADER;
+    if(demod_afsk_setup(sps,baud,mf,sf,prof,opts,D,SETUP_PLACE,(char *)mem+STATE_HEADER,avail)>avail) return NULL;
+    return D;
+}
+
+struct demodulator_state_s *demod_afsk_copy_in(void *mem,size_t size,const struct demodulator_state_s*src)
+{
+    if(size<STATE_HEADER || ((uintptr_t)mem&(STATE_ALIGN-1))) return NULL;
+    struct demodulator_state_s *D=mem;
+    char *base=(char *)mem+STATE_HEADER;
+
+    // The arrays are contiguous from src->arrays, whoever allocated them;
+    // only the pointers need moving. The filters stay shared.
+    *D=*src;
+    D->owned=NULL;
+    size_t need=demod_afsk_layout(D,NULL);
+    if(need>size-STATE_HEADER){
+        memset(D,0,sizeof(*D));
+        return NULL;
+    }
+    demod_afsk_layout(D,base);
+    memcpy(base,src->arrays,need);
+    pthread_mutex_lock(&coef_lock);
+    D->coef->refs++;
+    pthread_mutex_unlock(&coef_lock);
+    return D;
+}
+
+void demod_afsk_release(struct demodulator_state_s*D)
+{
+    free(D->owned);
+    coef_release(D->coef);
+    D->owned=NULL;
+    D->coef=NULL;
+}
+
+struct my_fsk_queue_s *demod_afsk_queue(struct demodulator_state_s*D,int slicer)
+{
+    if(slicer<0 || slicer>=D->num_queues) return NULL;
+    return &D->bits[slicer];
+}
+
+void demod_afsk_clear_bits(struct demodulator_state_s*D)
+{
+    for(int i=0;i<D->num_queues;i++) my_fsk_queue_clear(&D->bits[i]);
+}
+
+// Give an instance with its own arrays queues up to 'count' slicers. The
+// queues come first, so the delay lines move up by the added queues.
+static int grow_queues(struct demodulator_state_s*D,int count)
+{
+    if(!D->owned) return 0;
+    struct demodulator_state_s probe=*D;
+    size_t qsize=sizeof(struct my_fsk_queue_s);
+    size_t old_q=STATE_ROUND(D->num_queues*qsize), new_q=STATE_ROUND(count*qsize);
+    size_t old_need=demod_afsk_layout(&probe,NULL);
+    char *old=D->owned, *mem;
+    if(posix_memalign((void **)&mem,STATE_ALIGN,old_need-old_q+new_q)!=0) return 0;
+
+    memcpy(mem,old,D->num_queues*qsize);
+    for(int i=D->num_queues;i<count;i++) my_fsk_queue_init((struct my_fsk_queue_s *)(mem+i*qsize));
+    memcpy(mem+new_q,old+old_q,old_need-old_q);
+    D->num_queues=count;
+    demod_afsk_layout(D,mem);
+    D->owned=mem;
+    free(old);
+    return 1;
+}
+
+int demod_afsk_set_slicer(struct demodulator_state_s*D,int slicer,float threshold,
+                          float locked_inertia,float searching_inertia)
+{
+    if(slicer<0 || slicer>=MAX_SLICERS) return 0;
+    if(slicer>=D->num_queues && !grow_queues(D,slicer+1)) return 0;
+    slicer_config(D,slicer,threshold,locked_inertia,searching_inertia);
+    D->num_slicers=MAX(D->num_slicers,slicer+1);
+    return 1;
+}
+
+// Biquad cascade run as a wavefront: at each step section k takes the
+// sample section k-1 finished on the step before, so all IIR_MAX_SECTIONS
+// sections update at once as one vector operation instead of a chain of
+// dependent multiply-adds per section. Sections past pre_iir.sections
+// pass samples through; the price is a fixed IIR_MAX_SECTIONS-1 sample
+// delay, the same for every chunking of the input.
+static void iir_block(struct iir_cascade_s *c,const float *in,float *out,int count)
+{
+    float s1[IIR_MAX_SECTIONS], s2[IIR_MAX_SECTIONS], y[IIR_MAX_SECTIONS], v[IIR_MAX_SECTIONS];
+    memcpy(s1,c->s1,sizeof(s1));
+    memcpy(s2,c->s2,sizeof(s2));
+    memcpy(y,c->y,sizeof(y));
+
+    for(int i=0;i<count;i++){
+        v[0]=in[i];
+        for(int k=1;k<IIR_MAX_SECTIONS;k++) v[k]=y[k-1];
+        for(int k=0;k<IIR_MAX_SECTIONS;k++){
+            y[k]=c->b0[k]*v[k]+s1[k];
+            s1[k]=c->b1[k]*v[k]-c->a1[k]*y[k]+s2[k];
+            s2[k]=c->b2[k]*v[k]-c->a2[k]*y[k];
         }
-        unsigned int cp=(D->u.afsk.c_osc_phase>>24)&0xff;
-        float cos_c=fcos256_table[cp];
-        float sin_c=fcos256_table[((cp-64)&0xff)];
+        out[i]=y[IIR_MAX_SECTIONS-1];
+    }
 
-        push_sample(fsam*cos_c,D->u.afsk.c_I_raw,D->lp_filter_taps);
-        push_sample(fsam*sin_c,D->u.afsk.c_Q_raw,D->lp_filter_taps);
-        D->u.afsk.c_osc_phase += D->u.afsk.c_osc_delta;
+    memcpy(c->s1,s1,sizeof(s1));
+    memcpy(c->s2,s2,sizeof(s2));
+    memcpy(c->y,y,sizeof(y));
+}
+
+// Bandpass prefilter for a block: overlap-save when it was picked at init,
+// otherwise one FIR per sample through the delay line. Chunks shorter than
+// the filter, or than a full BLOCK_CHUNK for the longest ones (single
+// samples in particular), always take the direct FIR.
+// The delay line always ends up holding the latest raw samples, so the two
+// can be mixed freely.
+DEMOD_INLINE void prefilter_block(const float *in,float *out,int count,struct demodulator_state_s*D,
+                                  convolve_fn pre_conv,int taps)
+{
+    if(!D->use_prefilter){
+        memcpy(out,in,count*sizeof(float));
+        return;
+    }
+    if(D->use_iir){
+        iir_block(&D->pre_iir,in,out,count);
+        return;
+    }
+    if(!D->use_ols || count<MIN(taps,BLOCK_CHUNK)){
+        for(int i=0;i<count;i++){
+            push_sample(in[i],&D->raw_cb,taps);
+            out[i]=pre_conv(window_of(&D->raw_cb),D->pre_filter,taps);
+        }
+        return;
+    }
 
-        float c_I=convolve(D->u.afsk.c_I_raw,D->lp_filter,D->lp_filter_taps);
-        float c_Q=convolve(D->u.afsk.c_Q_raw,D->lp_filter,D->lp_filter_taps);
+    for(int i=0;i<count;i+=D->pre_ols->block){
+        int n=MIN(count-i,D->pre_ols->block);
+        ols_process(D->pre_ols,D->ols_work,window_of(&D->raw_cb),in+i,out+i,n);
+        for(int j=n-MIN(n,taps);j<n;j++) push_sample(in[i+j],&D->raw_cb,taps);
+    }
+}
+
+// Profile A/E detector: mark minus space envelope, each through its AGC,
+// from the lowpassed mark and space I/Q.
+DEMOD_INLINE float detect_a(struct demodulator_state_s*D,const float ms[4])
+{
+    float m_amp=fast_hypot(ms[0],ms[1]);
+    float s_amp=fast_hypot(ms[2],ms[3]);
+
+    float m_norm=agc(m_amp,D->agc_fast_attack,D->agc_slow_decay,&D->m_peak,&D->m_valley);
+    float s_norm=agc(s_amp,D->agc_fast_attack,D->agc_slow_decay,&D->s_peak,&D->s_valley);
+    return m_norm - s_norm;
+}
+
+// Profile B/D detector: phase step of the lowpassed center I/Q, scaled to
+// +/-1 at the tones.
+DEMOD_INLINE float detect_b(struct demodulator_state_s*D,float c_I,float c_Q)
+{
+    // Phase step since the last output, in radians.
+    float rate;
+    if(D->u.afsk.fm_disc==FM_DISC_ATAN2){
         float phase=atan2f(c_Q,c_I);
-        float rate=phase-D->u.afsk.prev_phase;
+        rate=phase-D->u.afsk.prev_phase;
         if(rate>M_PI) rate-=2.f*M_PI;
         else if(rate<-M_PI) rate+=2.f*M_PI;
         D->u.afsk.prev_phase=phase;
+    } else {
+        // z[n]*conj(z[n-1]): its angle is the step itself, so no unwrap.
+        float dot=c_I*D->u.afsk.prev_I+c_Q*D->u.afsk.prev_Q;
+        float cross=c_Q*D->u.afsk.prev_I-c_I*D->u.afsk.prev_Q;
+        if(D->u.afsk.fm_disc==FM_DISC_CONJ){
+            rate=fast_atan2f(cross,dot);
+        } else {
+            // cross = |z[n]||z[n-1]| sin(step); the mean power stands in
+            // for the product of magnitudes.
+            float power=c_I*c_I+c_Q*c_Q;
+            float norm=0.5f*(power+D->u.afsk.prev_power);
+            rate=(norm>0.f)?cross/norm:0.f;
+            D->u.afsk.prev_power=power;
+        }
+        D->u.afsk.prev_I=c_I;
+        D->u.afsk.prev_Q=c_Q;
+    }
+
+    return rate*D->u.afsk.normalize_rpsam;
+}
+
+// Profile A/E: two-tone envelope detector, from the prefiltered sample
+// already mixed down by the mark and space oscillators.
+DEMOD_INLINE void demod_afsk_profile_a(int chan,int subchan,float m_I,float m_Q,float s_I,float s_Q,struct demodulator_state_s*D,
+                                       convolve4_fn lp_conv4,int lp_taps)
+{
+    // Mark and space I/Q share lp_filter: one pass over the taps gives all four.
+    float ms[4];
+    push_sample4(m_I,m_Q,s_I,s_Q,&D->u.afsk.ms_IQ_raw,lp_taps);
+    if(--D->decim_count>0) return;
+    D->decim_count=D->decimate;
+    lp_conv4(window4_of(&D->u.afsk.ms_IQ_raw),D->lp_filter,lp_taps,ms);
+
+    float demod_out=detect_a(D,ms);
+    nudge_pll(chan,subchan,&demod_out,D,1.0f);
+}
+
+// Profile B/D: FM discriminator, from the prefiltered sample mixed down
+// by the center oscillator.
+DEMOD_INLINE void demod_afsk_profile_b(int chan,int subchan,float c_I,float c_Q,struct demodulator_state_s*D,
+                                       convolve2_fn lp_conv2,int lp_taps)
+{
+    float c[2];
+    push_sample2(c_I,c_Q,&D->u.afsk.c_IQ_raw,lp_taps);
+    if(--D->decim_count>0) return;
+    D->decim_count=D->decimate;
+    lp_conv2(window2_of(&D->u.afsk.c_IQ_raw),D->lp_filter,lp_taps,c);
+
+    float demod_out=detect_b(D,c[0],c[1]);
+    nudge_pll(chan,subchan,&demod_out,D,1.f);
+}
+
+// Running reliability of one detector output in profile C: with mean
+// |x| = m and variance of |x| = v, m/v is the maximal-ratio combining
+// weight (signal amplitude over noise power). A detector that cannot see
+// the tones (B's lowpass at 300 baud with a 1000 Hz shift, A against a
+// strong tilt) spreads its output and loses its say.
+DEMOD_INLINE float combine_weight(struct combine_level_s *c,float x,float alpha)
+{
+    float ax=fabsf(x);
+    c->mean_abs+=alpha*(ax-c->mean_abs);
+    c->mean_sq+=alpha*(x*x-c->mean_sq);
+    float var=c->mean_sq-c->mean_abs*c->mean_abs;
+    return c->mean_abs/(MAX(var,0.f)+1e-3f);
+}
+
+// Profile C: both detectors on one prefiltered sample, each with its own
+// lowpass (lp_filter for A, c_lp_filter for B). The main output is the
+// weighted mean of the two, a soft vote: where one detector is unsure the
+// other carries the decision. B is clipped to A's +/-1 range first so a
+// discriminator spike cannot outvote A on its own. Slicers 1 and 2 see
+// A and B alone, for callers that keep whichever frame validates.
+//
+// This part starts from the two lowpass outputs.
+DEMOD_INLINE void decide_c(int chan,int subchan,struct demodulator_state_s*D,const float ms[4],const float c[2])
+{
+    float a=detect_a(D,ms);
+    float b=detect_b(D,c[0],c[1]);
+
+    float wa=combine_weight(&D->u.afsk.combine[0],a,D->u.afsk.combine_alpha);
+    float wb=combine_weight(&D->u.afsk.combine[1],b,D->u.afsk.combine_alpha);
+    b=MIN(MAX(b,-1.f),1.f);
+    float demod_out[DEMOD_OUT_COUNT];
+    demod_out[DEMOD_OUT_MAIN]=(wa+wb>0.f)?(wa*a+wb*b)/(wa+wb):0.5f*(a+b);
+    demod_out[DEMOD_OUT_A]=a;
+    demod_out[DEMOD_OUT_B]=b;
+    nudge_pll(chan,subchan,demod_out,D,1.f);
+}
+
+// Profile C, from the prefiltered sample mixed down by all three
+// oscillators.
+DEMOD_INLINE void demod_afsk_profile_c(int chan,int subchan,float m_I,float m_Q,float s_I,float s_Q,
+                                       float c_I,float c_Q,struct demodulator_state_s*D,
+                                       convolve4_fn lp_conv4,int lp_taps,convolve2_fn c_lp_conv2,int c_lp_taps)
+{
+    float ms[4], c[2];
+    push_sample4(m_I,m_Q,s_I,s_Q,&D->u.afsk.ms_IQ_raw,lp_taps);
+    push_sample2(c_I,c_Q,&D->u.afsk.c_IQ_raw,lp_taps);
+    if(--D->decim_count>0) return;
+    D->decim_count=D->decimate;
+    lp_conv4(window4_of(&D->u.afsk.ms_IQ_raw),D->lp_filter,lp_taps,ms);
+    c_lp_conv2(window2_of(&D->u.afsk.c_IQ_raw)+2*D->u.afsk.c_lp_offset,D->u.afsk.c_lp_filter,c_lp_taps,c);
+    decide_c(chan,subchan,D,ms,c);
+}
+
+// Fixed-point path. Samples are int16 as received (the float path's
+// sam/16384 scaling only moves the binary point), filters are int16 with
+// the shift from quantize_q15(), and nothing below uses float.
+
+static inline int16_t sat16(int32_t v)
+{
+    return (int16_t)(v>32767?32767:(v<-32768?-32768:v));
+}
+
+static inline void push_q15(int16_t v,struct delay_line_q15_s *dl,int size){
+    dl->pos=(dl->pos>0)?dl->pos-1:size-1;
+    dl->buf[dl->pos]=dl->buf[dl->pos+size]=v;
+}
+
+static inline void push_q15x4(const int16_t *v,int lanes,struct delay_line_q15x4_s *dl,int size){
+    dl->pos=(dl->pos>0)?dl->pos-1:size-1;
+    for(int j=0;j<lanes;j++) dl->buf[j][dl->pos]=dl->buf[j][dl->pos+size]=v[j];
+}
+
+static inline int32_t fir_q15(const struct demodulator_state_s *D,const int16_t *data,const int16_t *filt,int taps,int shift){
+    return D->fir->dot_q15(data,filt,taps)>>shift;
+}
+
+// Integer square root, v < 2^32.
+static inline int32_t isqrt32(uint32_t v)
+{
+    uint32_t r=0, b=1u<<30;
+    while(b>v) b>>=2;
+    while(b){
+        if(v>=r+b){ v-=r+b; r=(r>>1)+b; }
+        else r>>=1;
+        b>>=2;
+    }
+    return (int32_t)r;
+}
+
+// atan2 as a binary angle (65536 per turn, so differences wrap for free).
+// atan(t) ~ t*pi/4 + 0.273*t*(1-t) on the first octant, about 0.004 rad
+// worst case; only the sign of the phase rate is used downstream.
+static inline int16_t atan2_bam(int32_t y,int32_t x)
+{
+    int32_t ax=x<0?-x:x, ay=y<0?-y:y;
+    if(ax==0 && ay==0) return 0;
+
+    int32_t t, a;
+    if(ay<=ax){
+        t=(ay<<15)/ax;
+        a=(t>>2)+(((t*(32768-t))>>15)*2850>>15);
+    } else {
+        t=(ax<<15)/ay;
+        a=16384-((t>>2)+(((t*(32768-t))>>15)*2850>>15));
+    }
+    if(x<0) a=32768-a;
+    if(y<0) a=-a;
+    return (int16_t)(uint16_t)a;
+}
 
-        float norm_rate=rate*D->u.afsk.normalize_rpsam;
-        nudge_pll(chan,subchan,norm_rate,D,1.f);
-      }
+// Same AGC as agc() with levels in amplitude<<AGC_Q_FRAC and Q24 constants.
+// Returns Q15, i.e. +/-16384 for the +/-0.5 swing of the float version.
+static inline int32_t agc_q15(int32_t amp,int32_t fa,int32_t sd,int32_t *ppeak,int32_t *pval)
+{
+    int32_t in=amp<<AGC_Q_FRAC;
+
+    if(in>=*ppeak) *ppeak+=(int32_t)(((int64_t)(in-*ppeak)*fa)>>24);
+    else           *ppeak+=(int32_t)(((int64_t)(in-*ppeak)*sd)>>24);
+
+    if(in<=*pval)  *pval+=(int32_t)(((int64_t)(in-*pval)*fa)>>24);
+    else           *pval+=(int32_t)(((int64_t)(in-*pval)*sd)>>24);
+
+    int32_t x=in;
+    if(x>*ppeak) x=*ppeak;
+    if(x<*pval)  x=*pval;
+    if(*ppeak>*pval){
+        int32_t range=*ppeak-*pval;
+        int32_t mid=*pval+range/2;
+        return (int32_t)(((int64_t)(x-mid)<<15)/range);
+    }
+    return 0;
+}
+
+static inline int16_t prefilter_sample_q15(int16_t sam,struct demodulator_state_s*D)
+{
+    if(D->use_prefilter){
+        push_q15(sam,&D->q.raw_cb,D->pre_filter_taps);
+        sam=sat16(fir_q15(D,D->q.raw_cb.buf+D->q.raw_cb.pos,D->q.pre_filter,D->pre_filter_taps,D->q.pre_shift));
+    }
+    return sam;
+}
+
+static inline void demod_afsk_profile_a_q15(int chan,int subchan,int16_t sam,struct demodulator_state_s*D)
+{
+    uint32_t mp=D->u.afsk.m_osc_phase;
+    int32_t cos_m=nco_cos_q15(mp), sin_m=nco_sin_q15(mp);
+    D->u.afsk.m_osc_phase += D->u.afsk.m_osc_delta;
+
+    uint32_t sp=D->u.afsk.s_osc_phase;
+    int32_t cos_s=nco_cos_q15(sp), sin_s=nco_sin_q15(sp);
+    D->u.afsk.s_osc_phase += D->u.afsk.s_osc_delta;
+
+    int16_t v[4]={ (int16_t)((sam*cos_m)>>15), (int16_t)((sam*sin_m)>>15),
+                   (int16_t)((sam*cos_s)>>15), (int16_t)((sam*sin_s)>>15) };
+    push_q15x4(v,4,&D->q.IQ_raw,D->lp_filter_taps);
+    if(--D->decim_count>0) return;
+    D->decim_count=D->decimate;
+
+    int32_t ms[4];
+    int pos=D->q.IQ_raw.pos;
+    for(int j=0;j<4;j++){
+        ms[j]=sat16(fir_q15(D,D->q.IQ_raw.buf[j]+pos,D->q.lp_filter,D->lp_filter_taps,D->q.lp_shift));
+    }
+
+    int32_t m_amp=isqrt32((uint32_t)(ms[0]*ms[0])+(uint32_t)(ms[1]*ms[1]));
+    int32_t s_amp=isqrt32((uint32_t)(ms[2]*ms[2])+(uint32_t)(ms[3]*ms[3]));
+
+    int32_t m_norm=agc_q15(m_amp,D->q.agc_fast_attack,D->q.agc_slow_decay,&D->q.m_peak,&D->q.m_valley);
+    int32_t s_norm=agc_q15(s_amp,D->q.agc_fast_attack,D->q.agc_slow_decay,&D->q.s_peak,&D->q.s_valley);
+
+    nudge_pll_q15(chan,subchan,m_norm-s_norm,D);
+}
+
+static inline void demod_afsk_profile_b_q15(int chan,int subchan,int16_t sam,struct demodulator_state_s*D)
+{
+    uint32_t cp=D->u.afsk.c_osc_phase;
+    int32_t cos_c=nco_cos_q15(cp), sin_c=nco_sin_q15(cp);
+    D->u.afsk.c_osc_phase += D->u.afsk.c_osc_delta;
+
+    int16_t v[2]={ (int16_t)((sam*cos_c)>>15), (int16_t)((sam*sin_c)>>15) };
+    push_q15x4(v,2,&D->q.IQ_raw,D->lp_filter_taps);
+    if(--D->decim_count>0) return;
+    D->decim_count=D->decimate;
+
+    int pos=D->q.IQ_raw.pos;
+    int32_t c_I=fir_q15(D,D->q.IQ_raw.buf[0]+pos,D->q.lp_filter,D->lp_filter_taps,D->q.lp_shift);
+    int32_t c_Q=fir_q15(D,D->q.IQ_raw.buf[1]+pos,D->q.lp_filter,D->lp_filter_taps,D->q.lp_shift);
+
+    // Phase step in binary angle; normalize_rpsam only scales it, so the
+    // slicer can take it as is.
+    int16_t phase=atan2_bam(c_Q,c_I);
+    int16_t rate=(int16_t)(uint16_t)(phase-D->q.prev_phase);
+    D->q.prev_phase=phase;
+
+    nudge_pll_q15(chan,subchan,rate,D);
+}
+
+static inline void demod_afsk_process_q15(int chan,int subchan,int16_t sam,struct demodulator_state_s*D)
+{
+    sam=prefilter_sample_q15(sam,D);
+
+    switch(D->profile){
+      case 'A':
+      case 'E':
+        demod_afsk_profile_a_q15(chan,subchan,sam,D);
+      break;
+
+      case 'B':
+      case 'D':
+        demod_afsk_profile_b_q15(chan,subchan,sam,D);
       break;
     }
 }
 
-static void nudge_pll(int chan,int subchan,float demod_out,struct demodulator_state_s*D,float amplitude)
+void demod_afsk_process_sample(int chan,int subchan,int sam,struct demodulator_state_s*D)
 {
-    signed int prev_pll=D->slicer[0].data_clock_pll;
-    unsigned int step_u=(unsigned int)D->pll_step_per_sample;
-    D->slicer[0].data_clock_pll=(signed int)((unsigned int)prev_pll+step_u);
+    if(D->fixed){
+        demod_afsk_process_q15(chan,subchan,sat16(sam),D);
+        return;
+    }
+
+    float fsam=(float)sam/16384.f;
+    D->process_chunk(chan,subchan,&fsam,1,D);
+}
+
+// Chunk processing: prefilter and mix the whole chunk first (straight
+// array loops), then run the lowpass/AGC/PLL per sample. With the
+// direct-form prefilter the bits do not depend on how the input is split.
+DEMOD_INLINE void demod_afsk_chunk_a(int chan,int subchan,const float *in,int count,struct demodulator_state_s*D,
+                                     convolve_fn pre_conv,int pre_taps,convolve4_fn lp_conv4,int lp_taps)
+{
+    float fs[BLOCK_CHUNK];
+    float c0[BLOCK_CHUNK], s0[BLOCK_CHUNK], c1[BLOCK_CHUNK], s1[BLOCK_CHUNK];
+    prefilter_block(in,fs,count,D,pre_conv,pre_taps);
+
+    nco_block(&D->u.afsk.m_osc_phase,D->u.afsk.m_osc_delta,count,c0,s0);
+    nco_block(&D->u.afsk.s_osc_phase,D->u.afsk.s_osc_delta,count,c1,s1);
+    for(int i=0;i<count;i++){
+        c0[i]*=fs[i]; s0[i]*=fs[i];
+        c1[i]*=fs[i]; s1[i]*=fs[i];
+    }
+    for(int i=0;i<count;i++){
+        demod_afsk_profile_a(chan,subchan,c0[i],s0[i],c1[i],s1[i],D,lp_conv4,lp_taps);
+    }
+}
+
+DEMOD_INLINE void demod_afsk_chunk_b(int chan,int subchan,const float *in,int count,struct demodulator_state_s*D,
+                                     convolve_fn pre_conv,int pre_taps,convolve2_fn lp_conv2,int lp_taps)
+{
+    float fs[BLOCK_CHUNK];
+    float c0[BLOCK_CHUNK], s0[BLOCK_CHUNK];
+    prefilter_block(in,fs,count,D,pre_conv,pre_taps);
+
+    nco_block(&D->u.afsk.c_osc_phase,D->u.afsk.c_osc_delta,count,c0,s0);
+    for(int i=0;i<count;i++){
+        c0[i]*=fs[i]; s0[i]*=fs[i];
+    }
+    for(int i=0;i<count;i++){
+        demod_afsk_profile_b(chan,subchan,c0[i],s0[i],D,lp_conv2,lp_taps);
+    }
+}
+
+// Profile C: one prefilter pass feeds all three mixers.
+DEMOD_INLINE void demod_afsk_chunk_c(int chan,int subchan,const float *in,int count,struct demodulator_state_s*D,
+                                     convolve_fn pre_conv,int pre_taps,convolve4_fn lp_conv4,int lp_taps,
+                                     convolve2_fn c_lp_conv2,int c_lp_taps)
+{
+    float fs[BLOCK_CHUNK];
+    float c0[BLOCK_CHUNK], s0[BLOCK_CHUNK], c1[BLOCK_CHUNK], s1[BLOCK_CHUNK];
+    float c2[BLOCK_CHUNK], s2[BLOCK_CHUNK];
+    prefilter_block(in,fs,count,D,pre_conv,pre_taps);
+
+    nco_block(&D->u.afsk.m_osc_phase,D->u.afsk.m_osc_delta,count,c0,s0);
+    nco_block(&D->u.afsk.s_osc_phase,D->u.afsk.s_osc_delta,count,c1,s1);
+    nco_block(&D->u.afsk.c_osc_phase,D->u.afsk.c_osc_delta,count,c2,s2);
+    for(int i=0;i<count;i++){
+        c0[i]*=fs[i]; s0[i]*=fs[i];
+        c1[i]*=fs[i]; s1[i]*=fs[i];
+        c2[i]*=fs[i]; s2[i]*=fs[i];
+    }
+    for(int i=0;i<count;i++){
+        demod_afsk_profile_c(chan,subchan,c0[i],s0[i],c1[i],s1[i],c2[i],s2[i],D,
+                             lp_conv4,lp_taps,c_lp_conv2,c_lp_taps);
+    }
+}
+
+// Profile G: sliding DFT at the mark and space tones over the last symbol,
+// then profile A's envelope AGC and slicing. A few multiplies per sample
+// whatever the baud rate: no prefilter, no lowpass, the rectangular
+// one-symbol window is the matched filter. Not specialized; there are no
+// tap counts to fix.
+static void chunk_g_generic(int chan,int subchan,const float *in,int count,struct demodulator_state_s*D)
+{
+    int n=D->u.afsk.sdft_len;
+    const float (*rot)[2]=D->u.afsk.sdft_rot;
+    const float (*tail)[2]=D->u.afsk.sdft_tail;
+    float m_re=D->u.afsk.sdft_bin[0][0], m_im=D->u.afsk.sdft_bin[0][1];
+    float s_re=D->u.afsk.sdft_bin[1][0], s_im=D->u.afsk.sdft_bin[1][1];
+
+    for(int i=0;i<count;i++){
+        float x=in[i];
+        push_sample(x,&D->raw_cb,n+1);
+        float x_old=window_of(&D->raw_cb)[n];
 
-    // crossing from + to -
-    if(D->slicer[0].data_clock_pll<0 && prev_pll>0){
-        int bit_val=(demod_out>0.f)?1:0;
-        int quality=(int)(fabsf(demod_out)*100.f/amplitude);
-        if(quality>100) quality=100;
+        float re=rot[0][0]*m_re-rot[0][1]*m_im+x-tail[0][0]*x_old;
+        m_im=rot[0][0]*m_im+rot[0][1]*m_re-tail[0][1]*x_old;
+        m_re=re;
+        re=rot[1][0]*s_re-rot[1][1]*s_im+x-tail[1][0]*x_old;
+        s_im=rot[1][0]*s_im+rot[1][1]*s_re-tail[1][1]*x_old;
+        s_re=re;
 
-        // raw bits:
-        my_fsk_rec_bit(bit_val);
+        if(--D->decim_count>0) continue;
+        D->decim_count=D->decimate;
+
+        float ms[4]={ m_re, m_im, s_re, s_im };
+        float demod_out=detect_a(D,ms);
+        nudge_pll(chan,subchan,&demod_out,D,1.f);
     }
 
-    int demod_data=(demod_out>0.f)?1:0;
-    if(demod_data!=D->slicer[0].prev_demod_data){
-        if(D->slicer[0].data_detect){
-            D->slicer[0].data_clock_pll=(int)(D->slicer[0].data_clock_pll*D->pll_locked_inertia);
+    D->u.afsk.sdft_bin[0][0]=m_re; D->u.afsk.sdft_bin[0][1]=m_im;
+    D->u.afsk.sdft_bin[1][0]=s_re; D->u.afsk.sdft_bin[1][1]=s_im;
+}
+
+// Generic chunk functions: kernels and tap counts picked at init.
+static void chunk_a_generic(int chan,int subchan,const float *in,int count,struct demodulator_state_s*D)
+{
+    demod_afsk_chunk_a(chan,subchan,in,count,D,D->pre_conv,D->pre_filter_taps,D->lp_conv4,D->lp_filter_taps);
+}
+
+static void chunk_b_generic(int chan,int subchan,const float *in,int count,struct demodulator_state_s*D)
+{
+    demod_afsk_chunk_b(chan,subchan,in,count,D,D->pre_conv,D->pre_filter_taps,D->lp_conv2,D->lp_filter_taps);
+}
+
+static void chunk_c_generic(int chan,int subchan,const float *in,int count,struct demodulator_state_s*D)
+{
+    demod_afsk_chunk_c(chan,subchan,in,count,D,D->pre_conv,D->pre_filter_taps,D->lp_conv4,D->lp_filter_taps,
+                       D->lp_conv2,D->u.afsk.c_lp_filter_taps);
+}
+
+// 16-bit delay lines (opts.half_storage): the generic chunk functions with
+// every pushed sample narrowed to the instance's format. The prefilter
+// input and the mixer outputs are packed a chunk at a time, and the FIRs
+// widen them again on load. One function for profiles A, B and C; the
+// profile tests are loop invariant.
+static inline void push_half(uint16_t *buf,int *pos,int size,int lanes,const uint16_t (*v)[BLOCK_CHUNK],int i)
+{
+    *pos=(*pos>0)?*pos-1:size-1;
+    uint16_t *p=buf+lanes*(*pos), *q=p+lanes*size;
+    for(int j=0;j<lanes;j++) p[j]=q[j]=v[j][i];
+}
+
+static inline void mix_half(const struct convolve_half_ops_s *h,const float *fs,int count,
+                            uint32_t *phase,uint32_t delta,uint16_t *hc,uint16_t *hs)
+{
+    float c[BLOCK_CHUNK], s[BLOCK_CHUNK];
+    nco_block(phase,delta,count,c,s);
+    for(int i=0;i<count;i++){
+        c[i]*=fs[i]; s[i]*=fs[i];
+    }
+    h->pack(c,hc,count);
+    h->pack(s,hs,count);
+}
+
+static void chunk_half_generic(int chan,int subchan,const float *in,int count,struct demodulator_state_s*D)
+{
+    const struct convolve_half_ops_s *h=D->half;
+    int pre_taps=D->pre_filter_taps, lp_taps=D->lp_filter_taps;
+    int use_a=(D->profile!='B' && D->profile!='D');
+    int use_b=(D->profile!='A' && D->profile!='E');
+    float fs[BLOCK_CHUNK];
+    uint16_t hv[6][BLOCK_CHUNK];    // m_I, m_Q, s_I, s_Q, c_I, c_Q
+
+    if(D->use_prefilter && !D->use_iir){
+        h->pack(in,hv[0],count);
+        for(int i=0;i<count;i++){
+            push_half(D->raw_cb.hbuf,&D->raw_cb.pos,pre_taps,1,hv,i);
+            fs[i]=h->dot(D->raw_cb.hbuf+D->raw_cb.pos,D->pre_filter,pre_taps);
+        }
+    } else {
+        prefilter_block(in,fs,count,D,D->pre_conv,pre_taps);
+    }
+
+    if(use_a){
+        mix_half(h,fs,count,&D->u.afsk.m_osc_phase,D->u.afsk.m_osc_delta,hv[0],hv[1]);
+        mix_half(h,fs,count,&D->u.afsk.s_osc_phase,D->u.afsk.s_osc_delta,hv[2],hv[3]);
+    }
+    if(use_b){
+        mix_half(h,fs,count,&D->u.afsk.c_osc_phase,D->u.afsk.c_osc_delta,hv[4],hv[5]);
+    }
+
+    struct delay_line4_s *ms_dl=&D->u.afsk.ms_IQ_raw;
+    struct delay_line2_s *c_dl=&D->u.afsk.c_IQ_raw;
+    for(int i=0;i<count;i++){
+        if(use_a) push_half(ms_dl->hbuf,&ms_dl->pos,lp_taps,4,hv,i);
+        if(use_b) push_half(c_dl->hbuf,&c_dl->pos,lp_taps,2,hv+4,i);
+        if(--D->decim_count>0) continue;
+        D->decim_count=D->decimate;
+
+        float ms[4], c[2], demod_out;
+        if(D->profile=='C'){
+            h->dot4(ms_dl->hbuf+4*ms_dl->pos,D->lp_filter,lp_taps,ms);
+            h->dot2(c_dl->hbuf+2*(c_dl->pos+D->u.afsk.c_lp_offset),D->u.afsk.c_lp_filter,D->u.afsk.c_lp_filter_taps,c);
+            decide_c(chan,subchan,D,ms,c);
+            continue;
+        }
+        if(use_a){
+            h->dot4(ms_dl->hbuf+4*ms_dl->pos,D->lp_filter,lp_taps,ms);
+            demod_out=detect_a(D,ms);
         } else {
-            D->slicer[0].data_clock_pll=(int)(D->slicer[0].data_clock_pll*D->pll_searching_inertia);
+            h->dot2(c_dl->hbuf+2*c_dl->pos,D->lp_filter,lp_taps,c);
+            demod_out=detect_b(D,c[0],c[1]);
+        }
+        nudge_pll(chan,subchan,&demod_out,D,1.f);
+    }
+}
+
+// Specialized chunk functions for the standard configurations: 300 and
+// 1200 baud at 44.1 and 48 kHz, one per profile, tap count pair and
+// instruction set. The folded kernels are inlined with constant trip
+// counts and there is no profile branch. demod_afsk_init_opts() binds one
+// when the filters match exactly; anything else (TUNE_* changes, other
+// rates) takes the generic functions. -DDEMOD_NO_SPECIALIZE drops them
+// for small builds.
+#define DEMOD_SPEC_LIST(X,isa)                                                \
+    X(a,isa,297,449) X(a,isa,273,411) X(a,isa,417,113) X(a,isa,383,103)       \
+    X(b,isa,297,321) X(b,isa,273,295) X(b,isa,327,81)  X(b,isa,299,73)
+
+#define DEMOD_SPEC_FN(prof,isa,pre,lp)                                        \
+    CONVOLVE_TARGET_##isa static void chunk_##prof##_##isa##_##pre##_##lp(   \
+        int chan,int subchan,const float *in,int count,struct demodulator_state_s*D) \
+    {                                                                         \
+        demod_afsk_chunk_##prof(chan,subchan,in,count,D,                      \
+                                dot_sym_##isa,pre,DEMOD_SPEC_LP_##prof(isa),lp); \
+    }
+#define DEMOD_SPEC_LP_a(isa) dot4_sym_##isa
+#define DEMOD_SPEC_LP_b(isa) dot2_sym_##isa
+
+#define DEMOD_SPEC_ENTRY(prof,isa,pre,lp)                                     \
+    { #isa, #prof[0], pre, lp, chunk_##prof##_##isa##_##pre##_##lp },
+
+struct demod_spec_s {
+    const char *isa;            // convolve_ops_s name
+    char group;                 // 'a' = profile A/E, 'b' = profile B/D
+    int pre_taps, lp_taps;
+    demod_chunk_fn fn;
+};
+
+#ifndef DEMOD_NO_SPECIALIZE
+DEMOD_SPEC_LIST(DEMOD_SPEC_FN,scalar)
+#ifdef CONVOLVE_X86
+DEMOD_SPEC_LIST(DEMOD_SPEC_FN,sse2)
+DEMOD_SPEC_LIST(DEMOD_SPEC_FN,avx2)
+DEMOD_SPEC_LIST(DEMOD_SPEC_FN,avx512)
+#endif
+#ifdef CONVOLVE_NEON
+DEMOD_SPEC_LIST(DEMOD_SPEC_FN,neon)
+#endif
+#endif
+
+static const struct demod_spec_s demod_specs[]={
+#ifndef DEMOD_NO_SPECIALIZE
+    DEMOD_SPEC_LIST(DEMOD_SPEC_ENTRY,scalar)
+#ifdef CONVOLVE_X86
+    DEMOD_SPEC_LIST(DEMOD_SPEC_ENTRY,sse2)
+    DEMOD_SPEC_LIST(DEMOD_SPEC_ENTRY,avx2)
+    DEMOD_SPEC_LIST(DEMOD_SPEC_ENTRY,avx512)
+#endif
+#ifdef CONVOLVE_NEON
+    DEMOD_SPEC_LIST(DEMOD_SPEC_ENTRY,neon)
+#endif
+#endif
+    { NULL, 0, 0, 0, NULL }
+};
+
+static int is_specialized(demod_chunk_fn fn)
+{
+    for(const struct demod_spec_s *p=demod_specs;p->fn;p++){
+        if(p->fn==fn) return 1;
+    }
+    return 0;
+}
+
+// Chunk function for this instance: a specialization if one matches.
+// Profiles C and G and 16-bit storage have none.
+static demod_chunk_fn demod_afsk_bind_chunk(const struct demodulator_state_s*D,int pre_sym,int lp_sym,int allow_spec)
+{
+    if(D->half) return chunk_half_generic;
+    if(D->profile=='C') return chunk_c_generic;
+    if(D->profile=='G') return chunk_g_generic;
+
+    char group=(D->profile=='A'||D->profile=='E')?'a':'b';
+
+    if(allow_spec && D->use_prefilter && pre_sym && lp_sym){
+        for(const struct demod_spec_s *p=demod_specs;p->fn;p++){
+            if(p->group==group && p->pre_taps==D->pre_filter_taps && p->lp_taps==D->lp_filter_taps &&
+               strcmp(p->isa,D->fir->name)==0){
+                return p->fn;
+            }
+        }
+    }
+    return (group=='a')?chunk_a_generic:chunk_b_generic;
+}
+
+void demod_afsk_process_block_s16(int chan,int subchan,const int16_t *samples,int count,struct demodulator_state_s*D)
+{
+    if(D->fixed){
+        for(int i=0;i<count;i++) demod_afsk_process_q15(chan,subchan,samples[i],D);
+        return;
+    }
+
+    float x[BLOCK_CHUNK];
+
+    for(int i=0;i<count;i+=BLOCK_CHUNK){
+        int n=MIN(count-i,BLOCK_CHUNK);
+        for(int j=0;j<n;j++) x[j]=(float)samples[i+j]/16384.f;
+        D->process_chunk(chan,subchan,x,n,D);
+    }
+}
+
+// Float samples are full scale at +/-1.0, matching the 32767 scaling the
+// Python wrapper applies before the int16 path (minus the quantization).
+void demod_afsk_process_block_f32(int chan,int subchan,const float *samples,int count,struct demodulator_state_s*D)
+{
+    if(D->fixed){
+        for(int i=0;i<count;i++){
+            demod_afsk_process_q15(chan,subchan,sat16((int32_t)lrintf(samples[i]*32767.f)),D);
+        }
+        return;
+    }
+
+    const float scale=32767.f/16384.f;
+    float x[BLOCK_CHUNK];
+
+    for(int i=0;i<count;i+=BLOCK_CHUNK){
+        int n=MIN(count-i,BLOCK_CHUNK);
+        for(int j=0;j<n;j++) x[j]=samples[i+j]*scale;
+        D->process_chunk(chan,subchan,x,n,D);
+    }
+}
+
+// Every slicer runs its own PLL on its demod_out[source]; only the source,
+// decision threshold and inertias differ.
+static void nudge_pll(int chan,int subchan,const float *demod_out,struct demodulator_state_s*D,float amplitude)
+{
+    // Bits go to the instance's own queues; chan and subchan only name it.
+    (void)chan;
+    (void)subchan;
+    unsigned int step_u=(unsigned int)D->pll_step_per_sample;
+
+    for(int i=0;i<D->num_slicers;i++){
+        float level=demod_out[D->slicer[i].source]-D->slicer[i].threshold;
+        signed int prev_pll=D->slicer[i].data_clock_pll;
+        D->slicer[i].data_clock_pll=(signed int)((unsigned int)prev_pll+step_u);
+
+        // crossing from + to -
+        if(D->slicer[i].data_clock_pll<0 && prev_pll>0){
+            int bit_val=(level>0.f)?1:0;
+            int quality=(int)(fabsf(level)*100.f/amplitude);
+            if(quality>100) quality=100;
+
+            // raw bits:
+            my_fsk_queue_put(&D->bits[i],bit_val);
+        }
+
+        int demod_data=(level>0.f)?1:0;
+        if(demod_data!=D->slicer[i].prev_demod_data){
+            if(D->slicer[i].data_detect){
+                D->slicer[i].data_clock_pll=(int)(D->slicer[i].data_clock_pll*D->slicer[i].locked_inertia);
+            } else {
+                D->slicer[i].data_clock_pll=(int)(D->slicer[i].data_clock_pll*D->slicer[i].searching_inertia);
+            }
+        }
+        D->slicer[i].prev_demod_data=demod_data;
+    }
+}
+
+// nudge_pll() with integer thresholds and inertia.
+static void nudge_pll_q15(int chan,int subchan,int32_t demod_out,struct demodulator_state_s*D)
+{
+    (void)chan;
+    (void)subchan;
+    unsigned int step_u=(unsigned int)D->pll_step_per_sample;
+
+    for(int i=0;i<D->num_slicers;i++){
+        signed int prev_pll=D->slicer[i].data_clock_pll;
+        D->slicer[i].data_clock_pll=(signed int)((unsigned int)prev_pll+step_u);
+
+        int demod_data=(demod_out>D->slicer[i].q_threshold)?1:0;
+
+        // crossing from + to -
+        if(D->slicer[i].data_clock_pll<0 && prev_pll>0){
+            my_fsk_queue_put(&D->bits[i],demod_data);
+        }
+
+        if(demod_data!=D->slicer[i].prev_demod_data){
+            int32_t inertia=D->slicer[i].data_detect?D->slicer[i].q_locked_inertia:D->slicer[i].q_searching_inertia;
+            D->slicer[i].data_clock_pll=(int)(((int64_t)D->slicer[i].data_clock_pll*inertia)/65536);
         }
+        D->slicer[i].prev_demod_data=demod_data;
     }
-    D->slicer[0].prev_demod_data=demod_data;
 }
@@ -2,26 +2,270 @@
 //
 // This file provides a factory function that allocates a new
 // 'demodulator_state_s' from the heap and returns it as an opaque pointer.
-// Also provides a matching free function.
+// Also provides a matching free function. The filters and delay lines are
+// allocated by demod_afsk_init() once their sizes are known.
+//
+// The pool (see demod_factory.h) maps one template slot followed by the
+// instance slots. The template is initialized once; handing out a slot
+// copies it there with demod_afsk_copy_in(), which costs a memcpy of the
+// state instead of a filter design. Each slot has an in-use flag, so a
+// slot given back twice is not handed out twice.
 
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "demod_afsk.h"  // So we know the type struct demodulator_state_s
+#include <sys/mman.h>
+#include <unistd.h>
+#include "demod_factory.h"
+
+// Huge page size assumed for rounding the mapping (x86-64 and the usual
+// arm64 configuration).
+#define POOL_HUGE_PAGE (2u*1024*1024)
+
+#ifndef MAP_POPULATE
+#define MAP_POPULATE 0
+#endif
+
+struct demod_pool_s {
+    char *map;
+    size_t map_size;
+    size_t slot_size;
+    int count;
+    int hugepages;
+
+    pthread_mutex_t lock;
+    int nfree;
+    unsigned char *in_use;  // per slot, indexed like free_list (1..count)
+    int free_list[];        // slot indices, a stack; in_use follows it
+};
 
-// Create & zero out a new demodulator_state_s, returning pointer.
+// Create & zero out a new demodulator_state_s, cache-line aligned,
+// returning pointer.
 struct demodulator_state_s * create_demodulator_state(void)
 {
-    struct demodulator_state_s *p = malloc(sizeof(*p));
-    if (p) {
-        memset(p, 0, sizeof(*p));
+    void *p;
+    if (posix_memalign(&p, 64, sizeof(struct demodulator_state_s)) != 0) {
+        return NULL;
     }
+    memset(p, 0, sizeof(struct demodulator_state_s));
     return p;
 }
 
-// Free an existing demodulator_state_s.
+// Free an existing demodulator_state_s and the arrays init gave it.
 void free_demodulator_state(struct demodulator_state_s *p)
 {
     if (p) {
+        demod_afsk_release(p);
         free(p);
     }
 }
+
+static size_t round_up(size_t n, size_t to)
+{
+    return (n + to - 1) / to * to;
+}
+
+// 1 if /proc/self/smaps shows transparent huge pages in the mapping that
+// holds 'p'. madvise() succeeding does not mean any were given: THP may
+// be disabled, or no aligned 2 MB range fits in the mapping.
+static int thp_backed(const void *p)
+{
+    char line[256];
+    unsigned long lo, hi;
+    int kb, in_map = 0, huge = 0;
+    FILE *f = fopen("/proc/self/smaps", "r");
+
+    if (!f) {
+        return 0;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "%lx-%lx ", &lo, &hi) == 2) {
+            if (in_map) {
+                break;
+            }
+            in_map = ((uintptr_t)p >= lo && (uintptr_t)p < hi);
+        } else if (in_map && sscanf(line, "AnonHugePages: %d", &kb) == 1) {
+            huge = (kb > 0);
+            break;
+        }
+    }
+    fclose(f);
+    return huge;
+}
+
+// Anonymous mapping of at least 'size' bytes (rounded up in place),
+// faulted in up front so that the first get of each slot takes no page
+// faults.
+static void *pool_map(size_t *size, int flags, int *hugepages)
+{
+    const int prot = PROT_READ | PROT_WRITE;
+    const int mflags = MAP_PRIVATE | MAP_ANONYMOUS;
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    void *p;
+
+    *hugepages = 0;
+    if (!(flags & DEMOD_POOL_HUGEPAGES)) {
+        *size = round_up(*size, page);
+        p = mmap(NULL, *size, prot, mflags | MAP_POPULATE, -1, 0);
+        return (p != MAP_FAILED) ? p : NULL;
+    }
+
+    *size = round_up(*size, POOL_HUGE_PAGE);
+#ifdef MAP_HUGETLB
+    p = mmap(NULL, *size, prot, mflags | MAP_POPULATE | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+        *hugepages = 1;
+        return p;
+    }
+#endif
+
+    // No reserved huge pages: ask for transparent ones. That only works
+    // before the pages are faulted in, so touch them after the madvise().
+    p = mmap(NULL, *size, prot, mflags, -1, 0);
+    if (p == MAP_FAILED) {
+        return NULL;
+    }
+#ifdef MADV_HUGEPAGE
+    int advised = (madvise(p, *size, MADV_HUGEPAGE) == 0);
+#endif
+    for (size_t i = 0; i < *size; i += page) {
+        ((volatile char *)p)[i] = 0;
+    }
+#ifdef MADV_HUGEPAGE
+    *hugepages = advised && thp_backed(p);
+#endif
+    return p;
+}
+
+struct demod_pool_s *demod_pool_create(int count, int sps, int baud, int mf, int sf, char prof,
+                                       const struct demod_afsk_opts_s *opts, int flags)
+{
+    struct demod_afsk_opts_s o;
+    struct demodulator_state_s probe;
+    struct demod_pool_s *P;
+
+    // Checked before any design runs: it exits on a bad profile.
+    if (count < 1 || sps <= 0 || baud <= 0 || baud >= sps) {
+        return NULL;
+    }
+    if (mf <= 0 || sf <= 0 || 2 * mf >= sps || 2 * sf >= sps) {
+        return NULL;
+    }
+    if (prof != 'A' && prof != 'B' && prof != 'C' && prof != 'D' && prof != 'E' && prof != 'G') {
+        return NULL;
+    }
+    if (opts) {
+        o = *opts;
+    } else {
+        demod_afsk_default_opts(&o);
+    }
+
+    P = malloc(sizeof(*P) + count * sizeof(int) + count + 1);
+    if (!P) {
+        return NULL;
+    }
+    P->count = count;
+    P->in_use = (unsigned char *)(P->free_list + count);
+    memset(P->in_use, 0, count + 1);
+
+    // Design once, on the heap: the probe holds the coefficients in the
+    // cache while the size is looked up and the template copied from it.
+    memset(&probe, 0, sizeof(probe));
+    demod_afsk_init_opts(sps, baud, mf, sf, prof, &o, &probe);
+    P->slot_size = round_up(demod_afsk_state_size(sps, baud, mf, sf, prof, &o), 64);
+    P->map_size = (count + 1) * P->slot_size;
+    P->map = pool_map(&P->map_size, flags, &P->hugepages);
+
+    // Slot 0 of the mapping is the template.
+    if (!P->map || !demod_afsk_copy_in(P->map, P->slot_size, &probe)) {
+        if (P->map) {
+            munmap(P->map, P->map_size);
+        }
+        demod_afsk_release(&probe);
+        free(P);
+        return NULL;
+    }
+    demod_afsk_release(&probe);
+
+    pthread_mutex_init(&P->lock, NULL);
+    P->nfree = count;
+    for (int i = 0; i < count; i++) {
+        P->free_list[i] = count - i;    // lowest address first
+    }
+    return P;
+}
+
+void demod_pool_free(struct demod_pool_s *P)
+{
+    if (P) {
+        demod_afsk_release((struct demodulator_state_s *)P->map);
+        pthread_mutex_destroy(&P->lock);
+        munmap(P->map, P->map_size);
+        free(P);
+    }
+}
+
+struct demodulator_state_s *demod_pool_get(struct demod_pool_s *P)
+{
+    int slot = -1;
+
+    pthread_mutex_lock(&P->lock);
+    if (P->nfree > 0) {
+        slot = P->free_list[--P->nfree];
+        P->in_use[slot] = 1;
+    }
+    pthread_mutex_unlock(&P->lock);
+
+    if (slot < 0) {
+        return NULL;
+    }
+    return demod_afsk_copy_in(P->map + slot * P->slot_size, P->slot_size,
+                              (const struct demodulator_state_s *)P->map);
+}
+
+void demod_pool_put(struct demod_pool_s *P, struct demodulator_state_s *D)
+{
+    size_t off;
+    int slot;
+
+    if (!D) {
+        return;
+    }
+    off = (size_t)((char *)D - P->map);
+    if ((char *)D < P->map + P->slot_size || off % P->slot_size != 0 ||
+        off / P->slot_size > (size_t)P->count) {
+        return;     // not one of ours
+    }
+    slot = (int)(off / P->slot_size);
+
+    pthread_mutex_lock(&P->lock);
+    if (P->in_use[slot]) {
+        P->in_use[slot] = 0;
+        demod_afsk_release(D);
+        P->free_list[P->nfree++] = slot;
+    }
+    pthread_mutex_unlock(&P->lock);
+}
+
+int demod_pool_available(struct demod_pool_s *P)
+{
+    int n;
+
+    pthread_mutex_lock(&P->lock);
+    n = P->nfree;
+    pthread_mutex_unlock(&P->lock);
+    return n;
+}
+
+size_t demod_pool_slot_size(const struct demod_pool_s *P)
+{
+    return P->slot_size;
+}
+
+int demod_pool_hugepages(const struct demod_pool_s *P)
+{
+    return P->hugepages;
+}
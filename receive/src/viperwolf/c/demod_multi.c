@@ -0,0 +1,353 @@
+// File: receive/src/viperwolf/c/demod_multi.c
+//
+// Multi-channel AFSK demodulator, see demod_multi.h. Same signal chain as
+// the float path of demod_afsk.c, but every per-channel value is a row of
+// lanes: the delay lines hold one row per sample with channel j in lane j,
+// the FIR kernels (convolve ops dotn/dotn_sym) filter all channels in one
+// pass, and AGC and PLL are straight loops over lanes. Rows are padded to
+// a multiple of 4 lanes; padding lanes carry zeros and never emit bits.
+//
+// A chunk goes through in three passes. The prefilter and the decision of
+// which frames produce an output run over all channels frame by frame. The
+// mixers and lowpass then run one group of channels at a time over the
+// whole chunk: the lowpass reads streams x channels x taps floats per
+// output, which for 16 channels is far more than L1 holds, while one
+// group's window (GROUP_WIDTH floats per row) stays in cache across the
+// chunk. Last, AGC and PLL run over all lanes for each output.
+
+#include "demod_multi.h"
+#include "convolve.h"
+#include "fsk_demod_state.h"
+#include "my_fsk.h"
+#include "nco.h"
+
+// Rows are this wide at most.
+#define MULTI_LANES ((MAX_CHANS+3)&~3)
+
+// Frames converted and mixed per pass.
+#define MULTI_CHUNK 128
+
+// Lowpass row width of one channel group: a 64-byte cache line.
+#define GROUP_WIDTH 16
+
+#define MIN(a,b) ((a)<(b)?(a):(b))
+
+struct demod_multi_s {
+    int nchan;
+    int lanes;              // nchan rounded up to a multiple of 4
+    int streams;            // lowpass streams per channel: 4 (A/E) or 2 (B/D)
+    int group;              // channels per lowpass group
+
+    // Filters, oscillators and constants from demod_afsk_init_opts(); the
+    // oscillator phases here advance for all channels at once.
+    struct demodulator_state_s cfg;
+    convolven_fn pre_conv;
+    convolven_fn lp_conv;
+    int decim_count;
+
+    // Mirrored delay lines (as in fsk_demod_state.h), one row per sample,
+    // sized to the taps at create. iq holds one line per channel group,
+    // each 'streams' x group wide; all of them are at the same position
+    // between chunks.
+    int raw_pos;
+    float *raw;
+    int iq_pos;
+    float *iq;
+
+    // Per channel:
+    float m_peak[MULTI_LANES], m_valley[MULTI_LANES];
+    float s_peak[MULTI_LANES], s_valley[MULTI_LANES];
+    float prev_phase[MULTI_LANES], prev_I[MULTI_LANES], prev_Q[MULTI_LANES], prev_power[MULTI_LANES];
+    int32_t pll[MULTI_LANES];
+    int32_t prev_data[MULTI_LANES];
+    int32_t data_detect[MULTI_LANES];
+    struct my_fsk_queue_s *bits;    // nchan queues
+
+    // Chunk scratch: prefiltered samples, oscillators, lowpass outputs.
+    float fs[MULTI_CHUNK*MULTI_LANES];
+    float osc[4][MULTI_CHUNK];
+    float lp[MULTI_CHUNK*4*MULTI_LANES];
+};
+
+struct demod_multi_s *demod_multi_create(int num_chans,int sps,int baud,int mf,int sf,char prof,
+                                         const struct demod_afsk_opts_s *opts)
+{
+    if(num_chans<1 || num_chans>MAX_CHANS) return NULL;
+    if(prof!='A' && prof!='E' && prof!='B' && prof!='D') return NULL;
+
+    struct demod_afsk_opts_s o;
+    if(opts) o=*opts;
+    else demod_afsk_default_opts(&o);
+    o.fixed_point=0;
+    o.prefilter_iir=IIR_NONE;
+    o.half_storage=HALF_STORAGE_NONE;
+
+    struct demod_multi_s *M=malloc(sizeof(*M));
+    if(!M) return NULL;
+    memset(M,0,sizeof(*M));
+
+    demod_afsk_init_config(sps,baud,mf,sf,prof,&o,&M->cfg);
+    M->nchan=num_chans;
+    M->lanes=(num_chans+3)&~3;
+    M->streams=(prof=='A'||prof=='E')?4:2;
+    M->group=MIN(M->lanes,GROUP_WIDTH/M->streams);
+    M->decim_count=1;
+
+    M->raw=calloc(2*(size_t)(M->cfg.pre_filter_taps+1)*M->lanes,sizeof(float));
+    M->iq=calloc(2*(size_t)M->cfg.lp_filter_taps*M->streams*M->lanes,sizeof(float));
+    if(posix_memalign((void **)&M->bits,64,num_chans*sizeof(*M->bits))!=0) M->bits=NULL;
+    if(!M->raw || !M->iq || !M->bits){
+        demod_multi_free(M);
+        return NULL;
+    }
+    for(int j=0;j<num_chans;j++) my_fsk_queue_init(&M->bits[j]);
+
+    const struct convolve_ops_s *fir=M->cfg.fir;
+    M->pre_conv=is_symmetric(M->cfg.pre_filter,M->cfg.pre_filter_taps)?fir->dotn_sym:fir->dotn;
+    M->lp_conv=is_symmetric(M->cfg.lp_filter,M->cfg.lp_filter_taps)?fir->dotn_sym:fir->dotn;
+    return M;
+}
+
+void demod_multi_free(struct demod_multi_s *M)
+{
+    if(!M) return;
+    demod_afsk_release(&M->cfg);
+    free(M->bits);
+    free(M->iq);
+    free(M->raw);
+    free(M);
+}
+
+struct my_fsk_queue_s *demod_multi_queue(struct demod_multi_s *M,int chan)
+{
+    if(chan<0 || chan>=M->nchan) return NULL;
+    return &M->bits[chan];
+}
+
+int demod_multi_num_chans(const struct demod_multi_s *M)
+{
+    return M->nchan;
+}
+
+// Push one row and return the newest-first window.
+static inline float *push_row(float *buf,int *pos,int size,int width,const float *row)
+{
+    *pos=(*pos>0)?*pos-1:size-1;
+    float *p=buf+(*pos)*width;
+    memcpy(p,row,width*sizeof(float));
+    memcpy(p+size*width,row,width*sizeof(float));
+    return p;
+}
+
+// agc() from demod_afsk.c across lanes. Written so the loop has no
+// branches left to vectorize around: the compiler will not speculate
+// float arithmetic past a condition, so conditions only pick between
+// values that are computed anyway.
+static inline void agc_lanes(const float *in,float fa,float sd,float *peak,float *valley,float *out,int lanes)
+{
+    for(int j=0;j<lanes;j++){
+        float x=in[j], p=peak[j], v=valley[j];
+        float wp=(x>=p)?fa:sd, wv=(x<=v)?fa:sd;
+        p=x*wp+p*(1.f-wp);
+        v=x*wv+v*(1.f-wv);
+        float c=(x>p)?p:x;
+        c=(c<v)?v:c;
+        float d=p-v;
+        float on=(float)(d>0.f);
+        float span=(d>1e-30f)?d:1e-30f;
+        out[j]=((c-0.5f*(p+v))*on)/span;
+        peak[j]=p; valley[j]=v;
+    }
+}
+
+// Profile A/E: lp holds mark I, mark Q, space I, space Q, 'lanes' each.
+static inline void demod_lanes_a(struct demod_multi_s *M,const float *lp,float *out)
+{
+    int L=M->lanes;
+    float m_amp[MULTI_LANES], s_amp[MULTI_LANES], m_norm[MULTI_LANES], s_norm[MULTI_LANES];
+
+    // sqrtf rather than hypotf: the squares cannot overflow at these
+    // levels. (errno handling keeps this loop scalar, but the square root
+    // itself is a single instruction.)
+    for(int j=0;j<L;j++){
+        m_amp[j]=sqrtf(lp[j]*lp[j]+lp[L+j]*lp[L+j]);
+        s_amp[j]=sqrtf(lp[2*L+j]*lp[2*L+j]+lp[3*L+j]*lp[3*L+j]);
+    }
+    agc_lanes(m_amp,M->cfg.agc_fast_attack,M->cfg.agc_slow_decay,M->m_peak,M->m_valley,m_norm,L);
+    agc_lanes(s_amp,M->cfg.agc_fast_attack,M->cfg.agc_slow_decay,M->s_peak,M->s_valley,s_norm,L);
+    for(int j=0;j<L;j++) out[j]=m_norm[j]-s_norm[j];
+}
+
+// Profile B/D: lp holds center I and Q, 'lanes' each.
+static inline void demod_lanes_b(struct demod_multi_s *M,const float *lp,float *out)
+{
+    int L=M->lanes;
+    const float *cI=lp, *cQ=lp+L;
+    float rate[MULTI_LANES];
+
+    switch(M->cfg.u.afsk.fm_disc){
+      case FM_DISC_ATAN2:
+        for(int j=0;j<L;j++){
+            float phase=atan2f(cQ[j],cI[j]);
+            float r=phase-M->prev_phase[j];
+            if(r>M_PI) r-=2.f*M_PI;
+            else if(r<-M_PI) r+=2.f*M_PI;
+            rate[j]=r;
+            M->prev_phase[j]=phase;
+        }
+      break;
+
+      case FM_DISC_CONJ:
+        for(int j=0;j<L;j++){
+            float dot=cI[j]*M->prev_I[j]+cQ[j]*M->prev_Q[j];
+            float cross=cQ[j]*M->prev_I[j]-cI[j]*M->prev_Q[j];
+            rate[j]=fast_atan2f(cross,dot);
+        }
+      break;
+
+      default:
+        for(int j=0;j<L;j++){
+            float cross=cQ[j]*M->prev_I[j]-cI[j]*M->prev_Q[j];
+            float power=cI[j]*cI[j]+cQ[j]*cQ[j];
+            float norm=0.5f*(power+M->prev_power[j]);
+            // norm is only 0 when cross is, so the floor leaves rate 0.
+            rate[j]=cross/((norm>1e-30f)?norm:1e-30f);
+            M->prev_power[j]=power;
+        }
+      break;
+    }
+    if(M->cfg.u.afsk.fm_disc!=FM_DISC_ATAN2){
+        memcpy(M->prev_I,cI,L*sizeof(float));
+        memcpy(M->prev_Q,cQ,L*sizeof(float));
+    }
+
+    float k=M->cfg.u.afsk.normalize_rpsam;
+    for(int j=0;j<L;j++) out[j]=rate[j]*k;
+}
+
+// nudge_pll() from demod_afsk.c across lanes. The clock update is branch
+// free (see agc_lanes()); bits go to the queues afterwards, only for lanes
+// that crossed.
+static inline void pll_lanes(struct demod_multi_s *M,const float *demod_out)
+{
+    int L=M->lanes;
+    uint32_t step=(uint32_t)M->cfg.pll_step_per_sample;
+    float locked=M->cfg.pll_locked_inertia, searching=M->cfg.pll_searching_inertia;
+    int32_t emit[MULTI_LANES], data[MULTI_LANES];
+
+    for(int j=0;j<L;j++){
+        int32_t prev=M->pll[j];
+        int32_t now=(int32_t)((uint32_t)prev+step);
+        int32_t d=(demod_out[j]>0.f);
+        float inertia=M->data_detect[j]?locked:searching;
+        int32_t nudged=(int32_t)((float)now*inertia);
+        int32_t flip=-(d!=M->prev_data[j]);
+        emit[j]=(now<0)&(prev>0);
+        data[j]=d;
+        M->pll[j]=(nudged&flip)|(now&~flip);
+        M->prev_data[j]=d;
+    }
+
+    for(int j=0;j<M->nchan;j++){
+        if(emit[j]) my_fsk_queue_put(&M->bits[j],data[j]);
+    }
+}
+
+// Mix and lowpass one channel group [g0,g0+gn) over a chunk. Lowpass
+// outputs for frame out_at[k] go to lp row k, at the lanes of the group.
+static void lowpass_group(struct demod_multi_s *M,int g0,int gn,int count,const int *out_at,int nout)
+{
+    struct demodulator_state_s *D=&M->cfg;
+    int L=M->lanes, S=M->streams, W=S*gn, taps=D->lp_filter_taps;
+    float *line=M->iq+2*taps*S*g0;
+    int pos=M->iq_pos;
+    float row[4*MULTI_LANES], out[4*MULTI_LANES];
+
+    for(int i=0,k=0;i<count;i++){
+        const float *fs=M->fs+i*L+g0;
+        for(int s=0;s<S;s++){
+            float osc=M->osc[s][i];
+            for(int j=0;j<gn;j++) row[s*gn+j]=fs[j]*osc;
+        }
+        const float *w=push_row(line,&pos,taps,W,row);
+
+        if(k<nout && out_at[k]==i){
+            M->lp_conv(w,D->lp_filter,taps,W,out);
+            for(int s=0;s<S;s++){
+                memcpy(M->lp+k*S*L+s*L+g0,out+s*gn,gn*sizeof(float));
+            }
+            k++;
+        }
+    }
+}
+
+// Up to MULTI_CHUNK frames, already scaled like sam/16384 and padded to
+// 'lanes' per frame.
+static void demod_multi_chunk(struct demod_multi_s *M,const float *x,int count)
+{
+    struct demodulator_state_s *D=&M->cfg;
+    int L=M->lanes;
+    int out_at[MULTI_CHUNK], nout=0;
+
+    for(int i=0;i<count;i++){
+        if(D->use_prefilter){
+            const float *w=push_row(M->raw,&M->raw_pos,D->pre_filter_taps,L,x+i*L);
+            M->pre_conv(w,D->pre_filter,D->pre_filter_taps,L,M->fs+i*L);
+        } else {
+            memcpy(M->fs+i*L,x+i*L,L*sizeof(float));
+        }
+        if(--M->decim_count>0) continue;
+        M->decim_count=D->decimate;
+        out_at[nout++]=i;
+    }
+
+    if(M->streams==4){
+        nco_block(&D->u.afsk.m_osc_phase,D->u.afsk.m_osc_delta,count,M->osc[0],M->osc[1]);
+        nco_block(&D->u.afsk.s_osc_phase,D->u.afsk.s_osc_delta,count,M->osc[2],M->osc[3]);
+    } else {
+        nco_block(&D->u.afsk.c_osc_phase,D->u.afsk.c_osc_delta,count,M->osc[0],M->osc[1]);
+    }
+
+    for(int g0=0;g0<L;g0+=M->group){
+        lowpass_group(M,g0,MIN(M->group,L-g0),count,out_at,nout);
+    }
+    M->iq_pos=(M->iq_pos-count%D->lp_filter_taps+D->lp_filter_taps)%D->lp_filter_taps;
+
+    for(int k=0;k<nout;k++){
+        float out[MULTI_LANES];
+        if(M->streams==4) demod_lanes_a(M,M->lp+k*4*L,out);
+        else              demod_lanes_b(M,M->lp+k*2*L,out);
+        pll_lanes(M,out);
+    }
+}
+
+void demod_multi_process_s16(struct demod_multi_s *M,const int16_t *frames,int count)
+{
+    float x[MULTI_CHUNK*MULTI_LANES];
+    int C=M->nchan, L=M->lanes;
+
+    memset(x,0,sizeof(x));
+    for(int i=0;i<count;i+=MULTI_CHUNK){
+        int n=MIN(count-i,MULTI_CHUNK);
+        for(int f=0;f<n;f++){
+            for(int j=0;j<C;j++) x[f*L+j]=(float)frames[(i+f)*C+j]/16384.f;
+        }
+        demod_multi_chunk(M,x,n);
+    }
+}
+
+void demod_multi_process_f32(struct demod_multi_s *M,const float *frames,int count)
+{
+    const float scale=32767.f/16384.f;
+    float x[MULTI_CHUNK*MULTI_LANES];
+    int C=M->nchan, L=M->lanes;
+
+    memset(x,0,sizeof(x));
+    for(int i=0;i<count;i+=MULTI_CHUNK){
+        int n=MIN(count-i,MULTI_CHUNK);
+        for(int f=0;f<n;f++){
+            for(int j=0;j<C;j++) x[f*L+j]=frames[(i+f)*C+j]*scale;
+        }
+        demod_multi_chunk(M,x,n);
+    }
+}
@@ -0,0 +1,302 @@
+// File: receive/src/viperwolf/c/demod_sched.c
+//
+// Worker pool for demodulator instances, see demod_sched.h. Rounds are
+// handed out with a generation counter under one mutex: the caller
+// publishes the blocks, bumps the generation and waits until every worker
+// has reported back. Workers only touch their own channels and their own
+// (cache-line aligned) counters, so nothing is shared while a round runs.
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "demod_sched.h"
+#include "textcolor.h"
+
+#define SCHED_MAX_WORKERS 64
+
+// The counters are read (and reset) from other threads while a round may
+// be running: relaxed atomics, as each is a tally on its own.
+#define LOAD(p)    __atomic_load_n(p,__ATOMIC_RELAXED)
+#define STORE(p,v) __atomic_store_n(p,v,__ATOMIC_RELAXED)
+
+struct sched_worker_s {
+    struct demod_sched_s *S;
+    pthread_t thread;
+    int index;
+    int cpu;
+    int started;
+
+    int nslots;
+    int *slots;             // in S->slot_table
+
+    // Counters, written by the worker during a round, see LOAD/STORE.
+    long blocks;
+    long samples;
+    int64_t busy_ns;
+} __attribute__((aligned(64)));
+
+struct demod_sched_s {
+    struct sched_worker_s workers[SCHED_MAX_WORKERS];
+    int nworkers;
+
+    // Channel tables, max_chans long. The slot table holds each worker's
+    // slots; adding to the least loaded worker keeps every worker within
+    // max_chans/nworkers, rounded up.
+    int max_chans;
+    int nslots;
+    int *chan;
+    struct demodulator_state_s **D;
+    int *slot_table;
+
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    unsigned long generation;
+    int pending;
+    int stop;
+
+    // Current round:
+    const void *const *blocks;
+    const int *counts;
+    int is_float;
+
+    int64_t stats_since_ns;
+};
+
+static int64_t now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC,&t);
+    return (int64_t)t.tv_sec*1000000000+t.tv_nsec;
+}
+
+static void run_round(struct sched_worker_s *W)
+{
+    struct demod_sched_s *S=W->S;
+    int64_t t0=now_ns();
+    long blocks=0, samples=0;
+
+    for(int i=0;i<W->nslots;i++){
+        int slot=W->slots[i];
+        int n=S->counts[slot];
+        if(n<=0) continue;
+        if(S->is_float){
+            demod_afsk_process_block_f32(S->chan[slot],0,(const float *)S->blocks[slot],n,S->D[slot]);
+        } else {
+            demod_afsk_process_block_s16(S->chan[slot],0,(const int16_t *)S->blocks[slot],n,S->D[slot]);
+        }
+        blocks++;
+        samples+=n;
+    }
+    STORE(&W->blocks,LOAD(&W->blocks)+blocks);
+    STORE(&W->samples,LOAD(&W->samples)+samples);
+    STORE(&W->busy_ns,LOAD(&W->busy_ns)+(now_ns()-t0));
+}
+
+static void *worker_main(void *arg)
+{
+    struct sched_worker_s *W=arg;
+    struct demod_sched_s *S=W->S;
+    unsigned long seen=0;
+
+    pthread_mutex_lock(&S->lock);
+    for(;;){
+        while(S->generation==seen && !S->stop) pthread_cond_wait(&S->start,&S->lock);
+        if(S->stop) break;
+        seen=S->generation;
+        pthread_mutex_unlock(&S->lock);
+
+        run_round(W);
+
+        pthread_mutex_lock(&S->lock);
+        if(--S->pending==0) pthread_cond_signal(&S->done);
+    }
+    pthread_mutex_unlock(&S->lock);
+    return NULL;
+}
+
+// CPU for worker i: the i-th one in this process's affinity mask,
+// wrapping around. -1 where affinity is not supported.
+static int worker_cpu(int i)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    if(sched_getaffinity(0,sizeof(set),&set)!=0) return -1;
+    int n=CPU_COUNT(&set);
+    if(n<=0) return -1;
+    for(int cpu=0,k=0;cpu<CPU_SETSIZE;cpu++){
+        if(CPU_ISSET(cpu,&set) && k++==i%n) return cpu;
+    }
+#else
+    (void)i;
+#endif
+    return -1;
+}
+
+static int available_cpus(void)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    if(sched_getaffinity(0,sizeof(set),&set)==0) return CPU_COUNT(&set);
+#endif
+    long n=sysconf(_SC_NPROCESSORS_ONLN);
+    return (n>0)?(int)n:1;
+}
+
+struct demod_sched_s *demod_sched_create(int num_workers,int pin,int max_chans)
+{
+    struct demod_sched_s *S;
+    if(max_chans<1) return NULL;
+    if(posix_memalign((void **)&S,64,sizeof(*S))!=0) return NULL;
+    memset(S,0,sizeof(*S));
+
+    if(num_workers<=0) num_workers=available_cpus();
+    if(num_workers>SCHED_MAX_WORKERS) num_workers=SCHED_MAX_WORKERS;
+
+    pthread_mutex_init(&S->lock,NULL);
+    pthread_cond_init(&S->start,NULL);
+    pthread_cond_init(&S->done,NULL);
+    S->stats_since_ns=now_ns();
+
+    for(int i=0;i<num_workers;i++){
+        struct sched_worker_s *W=&S->workers[i];
+        W->S=S;
+        W->index=i;
+        W->cpu=-1;
+        if(pthread_create(&W->thread,NULL,worker_main,W)!=0){
+            text_color_set(DW_COLOR_ERROR);
+            dw_printf("demod_sched: could not start worker %d\n",i);
+            break;
+        }
+        W->started=1;
+        S->nworkers++;
+
+#ifdef __linux__
+        if(pin){
+            int cpu=worker_cpu(i);
+            if(cpu>=0){
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(cpu,&set);
+                if(pthread_setaffinity_np(W->thread,sizeof(set),&set)==0) W->cpu=cpu;
+            }
+        }
+#else
+        (void)pin;
+#endif
+    }
+
+    if(S->nworkers==0){
+        demod_sched_free(S);
+        return NULL;
+    }
+
+    // The workers look at their slots only in a round, so the tables can
+    // be sized once it is known how many started.
+    int per_worker=(max_chans+S->nworkers-1)/S->nworkers;
+    S->max_chans=max_chans;
+    S->chan=calloc(max_chans,sizeof(*S->chan));
+    S->D=calloc(max_chans,sizeof(*S->D));
+    S->slot_table=calloc((size_t)S->nworkers*per_worker,sizeof(*S->slot_table));
+    if(!S->chan || !S->D || !S->slot_table){
+        demod_sched_free(S);
+        return NULL;
+    }
+    for(int i=0;i<S->nworkers;i++) S->workers[i].slots=S->slot_table+i*per_worker;
+    return S;
+}
+
+void demod_sched_free(struct demod_sched_s *S)
+{
+    if(!S) return;
+
+    pthread_mutex_lock(&S->lock);
+    S->stop=1;
+    pthread_cond_broadcast(&S->start);
+    pthread_mutex_unlock(&S->lock);
+
+    for(int i=0;i<SCHED_MAX_WORKERS;i++){
+        if(S->workers[i].started) pthread_join(S->workers[i].thread,NULL);
+    }
+    pthread_cond_destroy(&S->done);
+    pthread_cond_destroy(&S->start);
+    pthread_mutex_destroy(&S->lock);
+    free(S->slot_table);
+    free(S->D);
+    free(S->chan);
+    free(S);
+}
+
+int demod_sched_num_workers(const struct demod_sched_s *S)
+{
+    return S->nworkers;
+}
+
+int demod_sched_add(struct demod_sched_s *S,int chan,struct demodulator_state_s *D)
+{
+    if(S->nslots>=S->max_chans) return -1;
+
+    struct sched_worker_s *W=&S->workers[0];
+    for(int i=1;i<S->nworkers;i++){
+        if(S->workers[i].nslots<W->nslots) W=&S->workers[i];
+    }
+
+    // Workers only read the slot tables during a round, and rounds do not
+    // overlap with calls from the caller's thread.
+    int slot=S->nslots++;
+    S->chan[slot]=chan;
+    S->D[slot]=D;
+    W->slots[W->nslots++]=slot;
+    return slot;
+}
+
+static void run(struct demod_sched_s *S,const void *const *blocks,const int *counts,int is_float)
+{
+    pthread_mutex_lock(&S->lock);
+    S->blocks=blocks;
+    S->counts=counts;
+    S->is_float=is_float;
+    S->pending=S->nworkers;
+    S->generation++;
+    pthread_cond_broadcast(&S->start);
+    while(S->pending>0) pthread_cond_wait(&S->done,&S->lock);
+    pthread_mutex_unlock(&S->lock);
+}
+
+void demod_sched_process_s16(struct demod_sched_s *S,const int16_t *const *blocks,const int *counts)
+{
+    run(S,(const void *const *)blocks,counts,0);
+}
+
+void demod_sched_process_f32(struct demod_sched_s *S,const float *const *blocks,const int *counts)
+{
+    run(S,(const void *const *)blocks,counts,1);
+}
+
+void demod_sched_get_stats(const struct demod_sched_s *S,int worker,struct demod_sched_stats_s *stats)
+{
+    memset(stats,0,sizeof(*stats));
+    if(worker<0 || worker>=S->nworkers) return;
+
+    const struct sched_worker_s *W=&S->workers[worker];
+    stats->cpu=W->cpu;
+    stats->channels=W->nslots;
+    stats->blocks=LOAD(&W->blocks);
+    stats->samples=LOAD(&W->samples);
+    stats->busy_sec=LOAD(&W->busy_ns)*1e-9;
+    stats->wall_sec=(now_ns()-LOAD(&S->stats_since_ns))*1e-9;
+    stats->utilization=(stats->wall_sec>0.)?stats->busy_sec/stats->wall_sec:0.;
+}
+
+void demod_sched_reset_stats(struct demod_sched_s *S)
+{
+    for(int i=0;i<S->nworkers;i++){
+        STORE(&S->workers[i].blocks,0);
+        STORE(&S->workers[i].samples,0);
+        STORE(&S->workers[i].busy_ns,0);
+    }
+    STORE(&S->stats_since_ns,now_ns());
+}
@@ -7,6 +7,7 @@
  *   code but is enough to compile & run the single-slicer AFSK demod example.
  ******************************************************************************/
 
+#include <complex.h>
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
@@ -16,6 +17,8 @@
  * Minimal 'window' function that handles your two known bp_window_t modes:
  *   BP_WINDOW_TRUNCATED => returns 1.0 
  *   BP_WINDOW_COSINE    => returns a simple cosine shape
+ * plus BP_WINDOW_KAISER (beta for KAISER_DEFAULT_ATTEN_DB, see
+ * window_kaiser() for another beta) and BP_WINDOW_BLACKMAN_HARRIS.
  * Anything else defaults to 1.0
  */
 float window(bp_window_t type, int size, int j)
@@ -32,19 +35,102 @@ float window(bp_window_t type, int size, int j)
             return cosf(x);
         }
 
+        case BP_WINDOW_KAISER:
+            return window_kaiser(size, j, window_kaiser_beta(KAISER_DEFAULT_ATTEN_DB));
+
+        case BP_WINDOW_BLACKMAN_HARRIS:
+        {
+            if (size < 2) return 1.0f;
+            double x = 2.0 * M_PI * j / (size - 1);
+            return (float)(0.35875 - 0.48829 * cos(x) + 0.14128 * cos(2.0 * x)
+                           - 0.01168 * cos(3.0 * x));
+        }
+
         default:
             return 1.0f;
     }
 }
 
 /*----------------------------------------------------------------------------
- * gen_lowpass - Generate a simple lowpass filter via sinc * window.
- *   fc: cutoff fraction of sampling freq (0..0.5)
- *   lp_filter: output array of size filter_size
- *   filter_size: number of taps
- *   wtype: BP_WINDOW_TRUNCATED or BP_WINDOW_COSINE
+ * bessel_i0 - modified Bessel function of the first kind, order 0,
+ *   by its power series (converges quickly for the betas used here).
  *--------------------------------------------------------------------------*/
-void gen_lowpass(float fc, float *lp_filter, int filter_size, bp_window_t wtype)
+static double bessel_i0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    double q = 0.25 * x * x;
+    int k;
+
+    for (k = 1; k < 200 && term > 1.0e-12 * sum; k++)
+    {
+        term *= q / ((double)k * k);
+        sum += term;
+    }
+    return sum;
+}
+
+/*----------------------------------------------------------------------------
+ * window_kaiser - Kaiser window I0(beta*sqrt(1-t^2)) / I0(beta),
+ *   t running from -1 to 1 across the 'size' taps.
+ *--------------------------------------------------------------------------*/
+float window_kaiser(int size, int j, float beta)
+{
+    if (size < 2) return 1.0f;
+    double t = 2.0 * j / (size - 1) - 1.0;
+    double a = 1.0 - t * t;
+    return (float)(bessel_i0(beta * sqrt(a > 0.0 ? a : 0.0)) / bessel_i0(beta));
+}
+
+/*----------------------------------------------------------------------------
+ * window_kaiser_beta - Kaiser's empirical beta for a stopband attenuation
+ *   (dB) of a windowed-sinc filter.
+ *--------------------------------------------------------------------------*/
+float window_kaiser_beta(float atten_db)
+{
+    if (atten_db > 50.0f)
+    {
+        return 0.1102f * (atten_db - 8.7f);
+    }
+    if (atten_db >= 21.0f)
+    {
+        return 0.5842f * powf(atten_db - 21.0f, 0.4f) + 0.07886f * (atten_db - 21.0f);
+    }
+    return 0.0f;
+}
+
+/*----------------------------------------------------------------------------
+ * kaiser_taps - Kaiser's estimate of the taps for a windowed-sinc filter
+ *   with the given stopband attenuation (dB) and transition width
+ *   (fraction of sample rate). Always odd, so the filter has a center tap.
+ *--------------------------------------------------------------------------*/
+int kaiser_taps(float atten_db, float trans)
+{
+    if (trans <= 0.0f) return 1;
+    int taps = (int)ceilf((atten_db - 7.95f) / (14.36f * trans)) + 1;
+    if (taps < 3) taps = 3;
+    return taps | 1;
+}
+
+/*----------------------------------------------------------------------------
+ * fill_window - w[j] for j = 0..size-1; Kaiser with the given beta.
+ *--------------------------------------------------------------------------*/
+static void fill_window(bp_window_t wtype, float beta, float *w, int size)
+{
+    int j;
+
+    for (j = 0; j < size; j++)
+    {
+        w[j] = (wtype == BP_WINDOW_KAISER) ? window_kaiser(size, j, beta)
+                                           : window(wtype, size, j);
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * lowpass_windowed, bandpass_windowed - the sinc kernels behind
+ *   gen_lowpass() and gen_bandpass(). The filter array holds the window on
+ *   entry and is windowed in place, so no scratch is needed.
+ *--------------------------------------------------------------------------*/
+static void lowpass_windowed(float fc, float *lp_filter, int filter_size)
 {
     float sum = 0.0f;
     float center = 0.5f * (filter_size - 1);
@@ -64,8 +150,7 @@ void gen_lowpass(float fc, float *lp_filter, int filter_size, bp_window_t wtype)
             sinc = sinf(2.0f * (float)M_PI * fc * x) / ( (float)M_PI * x );
         }
 
-        float w = window(wtype, filter_size, i);
-        lp_filter[i] = sinc * w;
+        lp_filter[i] *= sinc;
         sum += lp_filter[i];
     }
 
@@ -77,16 +162,29 @@ void gen_lowpass(float fc, float *lp_filter, int filter_size, bp_window_t wtype)
     }
 }
 
-/*----------------------------------------------------------------------------
- * gen_bandpass - Generate a simple bandpass filter kernel for a prefilter.
- *   f1, f2: lower & upper cutoff frequencies (fraction of sample rate)
- *   bp_filter: output array of size filter_size
- *   filter_size: number of taps
- *   wtype: e.g. BP_WINDOW_TRUNCATED
- *--------------------------------------------------------------------------*/
-void gen_bandpass(float f1, float f2, float *bp_filter, int filter_size, bp_window_t wtype)
+/* Scale to unity gain at 'mid', which is approximated by the sum of cos
+   terms at 'mid' around the center tap. */
+static void normalize_bandpass(float *bp_filter, int filter_size, float mid)
+{
+    float center = 0.5f * (filter_size - 1);
+    float G = 0.0f;
+    int i;
+
+    for (i = 0; i < filter_size; i++)
+    {
+        float x = i - center;
+        G += 2.0f * bp_filter[i] * cosf(2.0f * (float)M_PI * mid * x);
+    }
+
+    if (fabsf(G) < 1.0e-12f) G = 1.0f;
+    for (i = 0; i < filter_size; i++)
+    {
+        bp_filter[i] /= G;
+    }
+}
+
+static void bandpass_windowed(float f1, float f2, float *bp_filter, int filter_size)
 {
-    float sum = 0.0f;
     float center = 0.5f * (filter_size - 1);
     int i;
 
@@ -106,26 +204,384 @@ void gen_bandpass(float f1, float f2, float *bp_filter, int filter_size, bp_wind
             y = (num1 - num2) / ((float)M_PI * x);
         }
 
-        float w = window(wtype, filter_size, i);
-        bp_filter[i] = y * w;
-        sum += bp_filter[i];
+        bp_filter[i] *= y;
     }
 
-    /* Normalize approx by measuring gain at middle freq = (f1+f2)/2 */
-    float mid = 0.5f * (f1 + f2);
-    float G = 0.0f;
-    for (i = 0; i < filter_size; i++)
+    normalize_bandpass(bp_filter, filter_size, 0.5f * (f1 + f2));
+}
+
+/*----------------------------------------------------------------------------
+ * gen_lowpass - Generate a simple lowpass filter via sinc * window.
+ *   fc: cutoff fraction of sampling freq (0..0.5)
+ *   lp_filter: output array of size filter_size
+ *   filter_size: number of taps
+ *   wtype: any bp_window_t
+ *--------------------------------------------------------------------------*/
+void gen_lowpass(float fc, float *lp_filter, int filter_size, bp_window_t wtype)
+{
+    fill_window(wtype, window_kaiser_beta(KAISER_DEFAULT_ATTEN_DB), lp_filter, filter_size);
+    lowpass_windowed(fc, lp_filter, filter_size);
+}
+
+/*----------------------------------------------------------------------------
+ * gen_bandpass - Generate a simple bandpass filter kernel for a prefilter.
+ *   f1, f2: lower & upper cutoff frequencies (fraction of sample rate)
+ *   bp_filter: output array of size filter_size
+ *   filter_size: number of taps
+ *   wtype: e.g. BP_WINDOW_TRUNCATED
+ *--------------------------------------------------------------------------*/
+void gen_bandpass(float f1, float f2, float *bp_filter, int filter_size, bp_window_t wtype)
+{
+    fill_window(wtype, window_kaiser_beta(KAISER_DEFAULT_ATTEN_DB), bp_filter, filter_size);
+    bandpass_windowed(f1, f2, bp_filter, filter_size);
+}
+
+/*----------------------------------------------------------------------------
+ * remez_eval - value at x = cos(w) of the polynomial through (x[k], c[k]),
+ *   k = 0..n-1, in barycentric form with weights b[k].
+ *--------------------------------------------------------------------------*/
+static double remez_eval(double xv, int n, const double *x, const double *b, const double *c)
+{
+    double num = 0.0, den = 0.0;
+    int k;
+
+    for (k = 0; k < n; k++)
     {
-        float x = i - center;
-        /* approximate amplitude by summation of cos terms at 'mid' */
-        G += 2.0f * bp_filter[i] * cosf(2.0f * (float)M_PI * mid * x);
+        double d = xv - x[k];
+        if (fabs(d) < 1.0e-14)
+        {
+            return c[k];
+        }
+        d = b[k] / d;
+        num += d * c[k];
+        den += d;
     }
+    return num / den;
+}
 
-    if (fabsf(G) < 1.0e-12f) G = 1.0f;
-    for (i = 0; i < filter_size; i++)
+/*----------------------------------------------------------------------------
+ * gen_equiripple - Parks-McClellan (Remez exchange) linear-phase FIR.
+ *   h: output, 'taps' coefficients; taps must be odd (type I)
+ *   nbands: number of bands
+ *   edges: 2*nbands band edges, increasing, fraction of sample rate
+ *   desired, weight: amplitude and error weight in each band
+ *   Returns 1 when the exchange converged, 0 otherwise (h is then the
+ *   last iterate, still a usable filter but not equiripple).
+ *
+ *   The amplitude response is a cosine polynomial of degree M = taps/2
+ *   in w; the weighted error alternates at M+2 extremal frequencies on a
+ *   grid of about 16 points per coefficient. The final response is
+ *   sampled at w = 2*pi*k/taps and the taps come from its inverse DFT.
+ *--------------------------------------------------------------------------*/
+int gen_equiripple(float *h, int taps, int nbands,
+                   const float *edges, const float *desired, const float *weight)
+{
+    int m = (taps - 1) / 2;
+    int r = m + 2;
+    int ngrid = 0, niter, converged = 0;
+    int i, j, k;
+
+    if (taps < 3 || !(taps & 1) || nbands < 1)
     {
-        bp_filter[i] /= G;
+        return 0;
+    }
+
+    /* Dense grid over the bands: x = cos(2 pi f), desired, weight */
+    double bw = 0.0;
+    for (j = 0; j < nbands; j++) bw += edges[2 * j + 1] - edges[2 * j];
+    double step = (bw > 0.0) ? bw / (16.0 * r) : 0.0;
+    int cap = 16 * r + 2 * nbands + 2;
+
+    double *gx = malloc(sizeof(double) * cap);
+    double *gd = malloc(sizeof(double) * cap);
+    double *gw = malloc(sizeof(double) * cap);
+    int *gband = malloc(sizeof(int) * cap);
+    int *ext = malloc(sizeof(int) * (r + 1));
+    int *cand = malloc(sizeof(int) * cap);
+    double *err = malloc(sizeof(double) * cap);
+    double *x = malloc(sizeof(double) * r);
+    double *b = malloc(sizeof(double) * r);
+    double *c = malloc(sizeof(double) * r);
+
+    if (!gx || !gd || !gw || !gband || !ext || !cand || !err || !x || !b || !c || step <= 0.0)
+    {
+        goto done;
     }
+
+    for (j = 0; j < nbands; j++)
+    {
+        double lo = edges[2 * j], hi = edges[2 * j + 1];
+        int n = (int)ceil((hi - lo) / step);
+        if (n < 1) n = 1;
+        for (i = 0; i <= n && ngrid < cap; i++)
+        {
+            double f = lo + (hi - lo) * i / n;
+            gx[ngrid] = cos(2.0 * M_PI * f);
+            gd[ngrid] = desired[j];
+            gw[ngrid] = weight[j];
+            gband[ngrid] = j;
+            ngrid++;
+        }
+    }
+    if (ngrid < r)
+    {
+        goto done;
+    }
+
+    for (k = 0; k < r; k++)
+    {
+        ext[k] = (int)((long)k * (ngrid - 1) / (r - 1));
+    }
+
+    double delta = 0.0;
+    for (niter = 0; niter < 40; niter++)
+    {
+        /* Barycentric weights on the r extremal points, then delta */
+        for (k = 0; k < r; k++) x[k] = gx[ext[k]];
+        for (k = 0; k < r; k++)
+        {
+            double p = 1.0;
+            for (j = 0; j < r; j++)
+            {
+                if (j != k) p *= 2.0 * (x[k] - x[j]);
+            }
+            b[k] = 1.0 / p;
+        }
+
+        double num = 0.0, den = 0.0;
+        for (k = 0; k < r; k++)
+        {
+            double sgn = (k & 1) ? -1.0 : 1.0;
+            num += b[k] * gd[ext[k]];
+            den += sgn * b[k] / gw[ext[k]];
+        }
+        delta = num / den;
+
+        /* Interpolate through the first r-1 points */
+        for (k = 0; k < r; k++)
+        {
+            double sgn = (k & 1) ? -1.0 : 1.0;
+            c[k] = gd[ext[k]] - sgn * delta / gw[ext[k]];
+        }
+        for (k = 0; k < r - 1; k++)
+        {
+            b[k] *= 2.0 * (x[k] - x[r - 1]);
+        }
+
+        double emax = 0.0;
+        for (i = 0; i < ngrid; i++)
+        {
+            err[i] = gw[i] * (gd[i] - remez_eval(gx[i], r - 1, x, b, c));
+            if (fabs(err[i]) > emax) emax = fabs(err[i]);
+        }
+
+        if (emax - fabs(delta) <= 1.0e-6 * fabs(delta))
+        {
+            converged = 1;
+            break;
+        }
+
+        /* Local extrema of the error (neighbors in the same band only),
+           alternating in sign */
+        int nc = 0;
+        for (i = 0; i < ngrid; i++)
+        {
+            double e = err[i];
+            int left = (i > 0 && gband[i - 1] == gband[i]);
+            int right = (i < ngrid - 1 && gband[i + 1] == gband[i]);
+            if (e > 0.0 && ((left && err[i - 1] > e) || (right && err[i + 1] > e))) continue;
+            if (e < 0.0 && ((left && err[i - 1] < e) || (right && err[i + 1] < e))) continue;
+
+            if (nc > 0 && (err[cand[nc - 1]] > 0.0) == (e > 0.0))
+            {
+                if (fabs(e) > fabs(err[cand[nc - 1]])) cand[nc - 1] = i;
+            }
+            else
+            {
+                cand[nc++] = i;
+            }
+        }
+        if (nc < r)
+        {
+            break;
+        }
+
+        /* Too many: remove the weakest adjacent pair, or with one to go
+           the smaller end; either keeps the alternation */
+        int first = 0;
+        while (nc - first > r)
+        {
+            if (nc - first == r + 1)
+            {
+                if (fabs(err[cand[first]]) < fabs(err[cand[nc - 1]])) first++;
+                else nc--;
+                continue;
+            }
+            int kmin = first;
+            double pmin = HUGE_VAL;
+            for (k = first; k < nc - 1; k++)
+            {
+                double p = fmax(fabs(err[cand[k]]), fabs(err[cand[k + 1]]));
+                if (p < pmin) { pmin = p; kmin = k; }
+            }
+            for (k = kmin; k < nc - 2; k++) cand[k] = cand[k + 2];
+            nc -= 2;
+        }
+
+        int same = 1;
+        for (k = 0; k < r; k++)
+        {
+            if (ext[k] != cand[first + k]) same = 0;
+            ext[k] = cand[first + k];
+        }
+        if (same)
+        {
+            converged = 1;
+            break;
+        }
+    }
+
+    /* Sample the amplitude response on the DFT grid, then invert */
+    {
+        double *a = err;    /* m+1 values, err has room */
+        for (k = 0; k <= m; k++)
+        {
+            a[k] = remez_eval(cos(2.0 * M_PI * k / taps), r - 1, x, b, c);
+        }
+        for (i = 0; i <= m; i++)
+        {
+            double v = a[0];
+            for (k = 1; k <= m; k++)
+            {
+                v += 2.0 * a[k] * cos(2.0 * M_PI * k * (i - m) / taps);
+            }
+            h[i] = h[taps - 1 - i] = (float)(v / taps);
+        }
+    }
+
+done:
+    free(gx); free(gd); free(gw); free(gband); free(ext);
+    free(cand); free(err); free(x); free(b); free(c);
+    return converged;
+}
+
+/*----------------------------------------------------------------------------
+ * equiripple_taps - Kaiser's estimate of the taps for an equiripple
+ *   filter with passband ripple dp and stopband ripple ds (linear) and
+ *   transition width 'trans' (fraction of sample rate). Odd.
+ *--------------------------------------------------------------------------*/
+static int equiripple_taps(double dp, double ds, float trans)
+{
+    if (trans <= 0.0f) return 1;
+    int taps = (int)ceil((-20.0 * log10(sqrt(dp * ds)) - 13.0) / (14.6 * trans)) + 1;
+    if (taps < 3) taps = 3;
+    return taps | 1;
+}
+
+/*----------------------------------------------------------------------------
+ * gen_bandpass_spec, gen_lowpass_spec - filters sized from a spec.
+ *   f1, f2 / fc: passband edges (fraction of sample rate); the stopbands
+ *     start spec->trans further out
+ *   spec: transition width, stopband attenuation, passband ripple
+ *   design: FILTER_DESIGN_KAISER or FILTER_DESIGN_EQUIRIPPLE
+ *   max_taps: upper limit; the spec is not met when it is reached
+ *   Returns the number of taps written (odd).
+ *
+ *   Kaiser: windowed sinc, beta and length from Kaiser's formulas.
+ *   Equiripple: Parks-McClellan with stopband weight dp/ds; it falls back
+ *   to Kaiser at the same length if the exchange does not converge.
+ *   Gains are normalized as gen_bandpass() and gen_lowpass() do.
+ *--------------------------------------------------------------------------*/
+int gen_bandpass_spec(float f1, float f2, const struct filter_spec_s *spec, int design,
+                      float *bp_filter, int max_taps)
+{
+    double g = pow(10.0, spec->ripple_db / 20.0);
+    double dp = (g - 1.0) / (g + 1.0);
+    double ds = pow(10.0, -spec->atten_db / 20.0);
+    float half = 0.5f * spec->trans;
+    int taps;
+
+    if (max_taps > MAX_FILTER_SIZE) max_taps = MAX_FILTER_SIZE;
+    max_taps = (max_taps - 1) | 1;
+
+    if (design == FILTER_DESIGN_EQUIRIPPLE)
+    {
+        taps = equiripple_taps(dp, ds, spec->trans);
+        if (taps > max_taps) taps = max_taps;
+
+        float edges[6], des[3], wt[3];
+        int nb = 0;
+        if (f1 - spec->trans > 0.0f)
+        {
+            edges[2 * nb] = 0.0f; edges[2 * nb + 1] = f1 - spec->trans;
+            des[nb] = 0.0f; wt[nb] = (float)(dp / ds); nb++;
+        }
+        edges[2 * nb] = f1; edges[2 * nb + 1] = f2;
+        des[nb] = 1.0f; wt[nb] = 1.0f; nb++;
+        if (f2 + spec->trans < 0.5f)
+        {
+            edges[2 * nb] = f2 + spec->trans; edges[2 * nb + 1] = 0.5f;
+            des[nb] = 0.0f; wt[nb] = (float)(dp / ds); nb++;
+        }
+
+        if (gen_equiripple(bp_filter, taps, nb, edges, des, wt))
+        {
+            normalize_bandpass(bp_filter, taps, 0.5f * (f1 + f2));
+            return taps;
+        }
+    }
+    else
+    {
+        taps = kaiser_taps(spec->atten_db, spec->trans);
+        if (taps > max_taps) taps = max_taps;
+    }
+
+    fill_window(BP_WINDOW_KAISER, window_kaiser_beta(spec->atten_db), bp_filter, taps);
+    bandpass_windowed(f1 - half, f2 + half, bp_filter, taps);
+    return taps;
+}
+
+int gen_lowpass_spec(float fc, const struct filter_spec_s *spec, int design,
+                     float *lp_filter, int max_taps)
+{
+    double g = pow(10.0, spec->ripple_db / 20.0);
+    double dp = (g - 1.0) / (g + 1.0);
+    double ds = pow(10.0, -spec->atten_db / 20.0);
+    float half = 0.5f * spec->trans;
+    int taps;
+
+    if (max_taps > MAX_FILTER_SIZE) max_taps = MAX_FILTER_SIZE;
+    max_taps = (max_taps - 1) | 1;
+
+    if (design == FILTER_DESIGN_EQUIRIPPLE)
+    {
+        taps = equiripple_taps(dp, ds, spec->trans);
+        if (taps > max_taps) taps = max_taps;
+
+        float edges[4] = { 0.0f, fc, fc + spec->trans, 0.5f };
+        float des[2] = { 1.0f, 0.0f };
+        float wt[2] = { 1.0f, (float)(dp / ds) };
+
+        if (fc + spec->trans < 0.5f &&
+            gen_equiripple(lp_filter, taps, 2, edges, des, wt))
+        {
+            float sum = 0.0f;
+            int i;
+            for (i = 0; i < taps; i++) sum += lp_filter[i];
+            if (fabsf(sum) < 1.0e-12f) sum = 1.0f;
+            for (i = 0; i < taps; i++) lp_filter[i] /= sum;
+            return taps;
+        }
+    }
+    else
+    {
+        taps = kaiser_taps(spec->atten_db, spec->trans);
+        if (taps > max_taps) taps = max_taps;
+    }
+
+    fill_window(BP_WINDOW_KAISER, window_kaiser_beta(spec->atten_db), lp_filter, taps);
+    lowpass_windowed(fc + half, lp_filter, taps);
+    return taps;
 }
 
 /*----------------------------------------------------------------------------
@@ -188,3 +644,265 @@ void gen_rrc_lowpass(float *pfilter, int taps, float rolloff, float sps)
     }
 }
 
+
+/*----------------------------------------------------------------------------
+ * cfft_double - in-place radix-2 complex FFT for the init-time design
+ *   code below (n a power of two). sign = -1 forward, +1 inverse
+ *   (unscaled).
+ *--------------------------------------------------------------------------*/
+static void cfft_double(double complex *z, int n, int sign)
+{
+    int i, j, len;
+
+    for (i = 1, j = 0; i < n; i++)
+    {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j)
+        {
+            double complex t = z[i];
+            z[i] = z[j];
+            z[j] = t;
+        }
+    }
+
+    for (len = 2; len <= n; len <<= 1)
+    {
+        double complex wl = cexp(sign * 2.0 * M_PI * I / len);
+        for (i = 0; i < n; i += len)
+        {
+            double complex w = 1.0;
+            for (j = 0; j < len / 2; j++)
+            {
+                double complex u = z[i + j];
+                double complex v = z[i + j + len / 2] * w;
+                z[i + j] = u + v;
+                z[i + j + len / 2] = u - v;
+                w *= wl;
+            }
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * make_min_phase - replace a filter by its minimum-phase counterpart,
+ *   same taps and (nearly) the same magnitude response, in place.
+ *   Returns 0 (filter unchanged) if out of memory.
+ *
+ *   Homomorphic method: the real cepstrum of log|H| is folded onto
+ *   positive quefrencies, which gives the minimum-phase log spectrum;
+ *   exp and an inverse FFT give the taps. The FFT is MIN_PHASE_OVERSAMPLE
+ *   times the filter length to keep cepstral aliasing down, and |H| is
+ *   floored MIN_PHASE_FLOOR_DB below its peak since stopband zeros would
+ *   take the log to -inf. The result is a linear-phase filter's
+ *   magnitude with most of its (taps-1)/2 samples of delay gone.
+ *--------------------------------------------------------------------------*/
+#define MIN_PHASE_OVERSAMPLE 16
+#define MIN_PHASE_FLOOR_DB 120.0
+
+int make_min_phase(float *filter, int taps)
+{
+    int n = 64;
+    int i;
+
+    while (n < MIN_PHASE_OVERSAMPLE * taps) n <<= 1;
+
+    double complex *z = malloc(sizeof(double complex) * n);
+    if (!z)
+    {
+        return 0;
+    }
+
+    for (i = 0; i < n; i++) z[i] = (i < taps) ? filter[i] : 0.0;
+    cfft_double(z, n, -1);
+
+    double peak = 0.0;
+    for (i = 0; i < n; i++)
+    {
+        if (cabs(z[i]) > peak) peak = cabs(z[i]);
+    }
+    double floor_mag = peak * pow(10.0, -MIN_PHASE_FLOOR_DB / 20.0);
+    if (floor_mag <= 0.0) floor_mag = 1.0e-300;
+
+    /* Real cepstrum */
+    for (i = 0; i < n; i++)
+    {
+        double m = cabs(z[i]);
+        z[i] = log(m > floor_mag ? m : floor_mag);
+    }
+    cfft_double(z, n, 1);
+    for (i = 0; i < n; i++) z[i] = creal(z[i]) / n;
+
+    /* Fold: causal part doubled, anticausal part dropped */
+    for (i = 1; i < n / 2; i++) z[i] *= 2.0;
+    for (i = n / 2 + 1; i < n; i++) z[i] = 0.0;
+
+    cfft_double(z, n, -1);
+    for (i = 0; i < n; i++) z[i] = cexp(z[i]);
+    cfft_double(z, n, 1);
+
+    for (i = 0; i < taps; i++) filter[i] = (float)(creal(z[i]) / n);
+
+    free(z);
+    return 1;
+}
+
+/*----------------------------------------------------------------------------
+ * is_symmetric - nonzero if filter[i] == filter[taps-1-i] for all i,
+ *   i.e. the filter is linear-phase and can use a folded FIR kernel.
+ *   A tiny relative tolerance absorbs rounding in the generators.
+ *--------------------------------------------------------------------------*/
+int is_symmetric(const float *filter, int taps)
+{
+    float peak = 0.0f;
+    int i;
+
+    for (i = 0; i < taps; i++)
+    {
+        if (fabsf(filter[i]) > peak) peak = fabsf(filter[i]);
+    }
+
+    for (i = 0; i < taps / 2; i++)
+    {
+        if (fabsf(filter[i] - filter[taps - 1 - i]) > 1.0e-6f * peak)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+
+/*----------------------------------------------------------------------------
+ * quantize_q15 - int16 coefficients for the fixed-point demodulator.
+ *   q[i] = round(filter[i] * 2^shift); returns shift.
+ *   The shift is as large as possible while every coefficient fits in
+ *   int16 and a full-scale int16 input cannot overflow the 32-bit
+ *   accumulator (sum of |q[i]| < 2^16, rounding included). Shift 15 is
+ *   plain Q15.
+ *--------------------------------------------------------------------------*/
+int quantize_q15(const float *filter, int taps, int16_t *q)
+{
+    double peak = 0.0, sum = 0.0;
+    int shift = 0;
+    int i;
+
+    for (i = 0; i < taps; i++)
+    {
+        double a = fabs((double)filter[i]);
+        if (a > peak) peak = a;
+        sum += a;
+    }
+
+    while (shift < 30 &&
+           peak * ldexp(1.0, shift + 1) < 32767.0 &&
+           sum * ldexp(1.0, shift + 1) + 0.5 * taps < 65536.0)
+    {
+        shift++;
+    }
+
+    for (i = 0; i < taps; i++)
+    {
+        q[i] = (int16_t)lrint(ldexp((double)filter[i], shift));
+    }
+    return shift;
+}
+
+
+/*----------------------------------------------------------------------------
+ * gen_iir_bandpass - Butterworth or Chebyshev (type I) bandpass biquads.
+ *   f1, f2: band edges (fraction of sample rate); -3 dB for Butterworth,
+ *           the ripple level for Chebyshev
+ *   sections: lowpass prototype order = number of biquads
+ *   ripple_db: Chebyshev passband ripple, ignored for Butterworth
+ *   sos: output, sections sorted by pole radius (sharpest last)
+ *
+ *   Analog prototype poles go through the lowpass-to-bandpass transform
+ *   at the prewarped edges and then the bilinear transform. Every section
+ *   gets one conjugate pole pair and a zero at z = 1 and z = -1, and is
+ *   scaled to unity gain at the band center, so no stage can clip.
+ *--------------------------------------------------------------------------*/
+int gen_iir_bandpass(float f1, float f2, int sections, iir_type_t type,
+                     float ripple_db, struct biquad_s *sos)
+{
+    double complex zp[IIR_MAX_SECTIONS];
+    int n = sections;
+    int nz = 0;
+    int i, k;
+
+    if (n < 1 || n > IIR_MAX_SECTIONS || f1 <= 0.0f || f2 <= f1 || f2 >= 0.5f)
+    {
+        return 0;
+    }
+
+    /* Prewarped analog band edges, T = 1 */
+    double w1 = 2.0 * tan(M_PI * f1);
+    double w2 = 2.0 * tan(M_PI * f2);
+    double w0 = sqrt(w1 * w2);
+    double bw = w2 - w1;
+
+    double mu = 0.0;
+    if (type == IIR_CHEBYSHEV)
+    {
+        double eps = sqrt(pow(10.0, 0.1 * ripple_db) - 1.0);
+        mu = asinh(1.0 / eps) / n;
+    }
+
+    for (k = 0; k < n; k++)
+    {
+        double th = M_PI * (2 * k + 1) / (2.0 * n);
+        double complex p;
+        if (type == IIR_CHEBYSHEV)
+        {
+            p = -sinh(mu) * sin(th) + I * cosh(mu) * cos(th);
+        }
+        else
+        {
+            p = -sin(th) + I * cos(th);
+        }
+
+        /* s^2 - p*bw*s + w0^2 = 0 gives the two bandpass poles */
+        double complex pb = p * bw;
+        double complex d = csqrt(pb * pb - 4.0 * w0 * w0);
+        double complex s[2] = { 0.5 * (pb + d), 0.5 * (pb - d) };
+
+        for (i = 0; i < 2; i++)
+        {
+            double complex z = (2.0 + s[i]) / (2.0 - s[i]);
+            if (cimag(z) > 0.0)
+            {
+                if (nz == n) return 0;
+                zp[nz++] = z;
+            }
+        }
+    }
+    if (nz != n) return 0;
+
+    /* One conjugate pair per section, least resonant first */
+    for (i = 1; i < n; i++)
+    {
+        for (k = i; k > 0 && cabs(zp[k]) < cabs(zp[k - 1]); k--)
+        {
+            double complex t = zp[k];
+            zp[k] = zp[k - 1];
+            zp[k - 1] = t;
+        }
+    }
+
+    double complex e1 = cexp(-I * 2.0 * atan(0.5 * w0));   /* z^-1 at the center */
+    for (i = 0; i < n; i++)
+    {
+        double a1 = -2.0 * creal(zp[i]);
+        double a2 = cabs(zp[i]) * cabs(zp[i]);
+        double complex h = (1.0 - e1 * e1) / (1.0 + a1 * e1 + a2 * e1 * e1);
+        double g = 1.0 / cabs(h);
+
+        sos[i].b0 = (float)g;
+        sos[i].b1 = 0.0f;
+        sos[i].b2 = (float)-g;
+        sos[i].a1 = (float)a1;
+        sos[i].a2 = (float)a2;
+    }
+    return n;
+}
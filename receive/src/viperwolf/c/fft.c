@@ -0,0 +1,273 @@
+/******************************************************************************
+ * File: fft.c
+ *
+ * Purpose:
+ *   Small self-contained real FFT and an overlap-save FIR built on it.
+ *   Used by demod_afsk.c to run long prefilters on block input at
+ *   O(log n) cost per sample instead of O(taps).
+ ******************************************************************************/
+
+#include <math.h>
+#include <string.h>
+#include "fft.h"
+
+/*----------------------------------------------------------------------------
+ * fft_table_size - Bytes of bit reversal and twiddles for size n.
+ *   n: power of two, 4 <= n <= FFT_MAX_SIZE
+ *   Returns 0 if n is not supported.
+ *--------------------------------------------------------------------------*/
+size_t fft_table_size(int n)
+{
+    if (n < 4 || n > FFT_MAX_SIZE || (n & (n - 1)) != 0)
+    {
+        return 0;
+    }
+    return (n / 2) * sizeof(int) + (n / 2 + n) * sizeof(float);
+}
+
+/*----------------------------------------------------------------------------
+ * fft_init - Prepare twiddles and bit reversal for a real FFT of size n.
+ *   tables: fft_table_size(n) bytes, int aligned
+ *   Returns 0 if n is not supported.
+ *--------------------------------------------------------------------------*/
+int fft_init(struct fft_s *F, int n, void *tables)
+{
+    int m = n / 2;
+    int bits = 0;
+    int i;
+
+    if (fft_table_size(n) == 0)
+    {
+        return 0;
+    }
+
+    F->n = n;
+    F->rev = tables;
+    F->tw = (float *)(F->rev + m);
+    F->rtw = F->tw + m;
+    while ((1 << bits) < m) bits++;
+
+    for (i = 0; i < m; i++)
+    {
+        int r = 0;
+        for (int b = 0; b < bits; b++)
+        {
+            if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+        }
+        F->rev[i] = r;
+    }
+
+    /* Twiddles are computed in double so the table itself adds no error. */
+    for (i = 0; i < m / 2; i++)
+    {
+        double a = -2.0 * M_PI * i / m;
+        F->tw[2 * i]     = (float)cos(a);
+        F->tw[2 * i + 1] = (float)sin(a);
+    }
+    for (i = 0; i < m; i++)
+    {
+        double a = -2.0 * M_PI * i / n;
+        F->rtw[2 * i]     = (float)cos(a);
+        F->rtw[2 * i + 1] = (float)sin(a);
+    }
+    return 1;
+}
+
+/*----------------------------------------------------------------------------
+ * cfft - In-place radix-2 complex FFT of n/2 interleaved points.
+ *   inverse: nonzero for the (unscaled) inverse transform.
+ *--------------------------------------------------------------------------*/
+static void cfft(const struct fft_s *F, float *z, int inverse)
+{
+    int m = F->n / 2;
+    float sgn = inverse ? -1.0f : 1.0f;
+
+    for (int i = 0; i < m; i++)
+    {
+        int j = F->rev[i];
+        if (i < j)
+        {
+            float tr = z[2 * i], ti = z[2 * i + 1];
+            z[2 * i] = z[2 * j]; z[2 * i + 1] = z[2 * j + 1];
+            z[2 * j] = tr;       z[2 * j + 1] = ti;
+        }
+    }
+
+    for (int len = 2; len <= m; len <<= 1)
+    {
+        int half = len / 2;
+        int step = m / len;
+        for (int i = 0; i < m; i += len)
+        {
+            for (int k = 0; k < half; k++)
+            {
+                float wr = F->tw[2 * k * step];
+                float wi = F->tw[2 * k * step + 1] * sgn;
+                float *a = z + 2 * (i + k);
+                float *b = z + 2 * (i + k + half);
+                float br = b[0] * wr - b[1] * wi;
+                float bi = b[0] * wi + b[1] * wr;
+                b[0] = a[0] - br; b[1] = a[1] - bi;
+                a[0] += br;       a[1] += bi;
+            }
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * fft_real_forward - Spectrum of n real samples.
+ *   spec: n/2+1 complex bins (n+2 floats); may be the same array as 'in'
+ *--------------------------------------------------------------------------*/
+void fft_real_forward(const struct fft_s *F, const float *in, float *spec)
+{
+    int m = F->n / 2;
+
+    /* Even samples as real part, odd samples as imaginary part. */
+    if (spec != in) memcpy(spec, in, F->n * sizeof(float));
+    cfft(F, spec, 0);
+
+    /* Split into the spectrum of the real sequence. k and m-k share inputs,
+       so both are produced in the same step. */
+    float z0r = spec[0], z0i = spec[1];
+    spec[0] = z0r + z0i; spec[1] = 0.0f;
+    spec[2 * m] = z0r - z0i; spec[2 * m + 1] = 0.0f;
+
+    for (int k = 1; k <= m / 2; k++)
+    {
+        float ar = spec[2 * k],       ai = spec[2 * k + 1];
+        float br = spec[2 * (m - k)], bi = -spec[2 * (m - k) + 1];   /* conj */
+        float er = 0.5f * (ar + br), ei = 0.5f * (ai + bi);           /* even */
+        float or_ = 0.5f * (ai - bi), oi = -0.5f * (ar - br);         /* odd  */
+        float wr = F->rtw[2 * k], wi = F->rtw[2 * k + 1];
+        float tr = or_ * wr - oi * wi, ti = or_ * wi + oi * wr;
+        spec[2 * k]           = er + tr;
+        spec[2 * k + 1]       = ei + ti;
+        spec[2 * (m - k)]     = er - tr;
+        spec[2 * (m - k) + 1] = -(ei - ti);
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * fft_real_inverse - n real samples from n/2+1 bins, scaled by n/2.
+ *   spec is used as scratch and destroyed; 'out' may be the same array.
+ *--------------------------------------------------------------------------*/
+void fft_real_inverse(const struct fft_s *F, float *spec, float *out)
+{
+    int m = F->n / 2;
+
+    float x0 = spec[0], xm = spec[2 * m];
+    spec[0] = 0.5f * (x0 + xm);
+    spec[1] = 0.5f * (x0 - xm);
+
+    for (int k = 1; k <= m / 2; k++)
+    {
+        float ar = spec[2 * k],       ai = spec[2 * k + 1];
+        float br = spec[2 * (m - k)], bi = -spec[2 * (m - k) + 1];   /* conj */
+        float er = 0.5f * (ar + br), ei = 0.5f * (ai + bi);
+        float dr = 0.5f * (ar - br), di = 0.5f * (ai - bi);
+        /* odd part = d * conj(w), then z = even + j*odd */
+        float wr = F->rtw[2 * k], wi = -F->rtw[2 * k + 1];
+        float or_ = dr * wr - di * wi, oi = dr * wi + di * wr;
+        spec[2 * k]           = er - oi;
+        spec[2 * k + 1]       = ei + or_;
+        spec[2 * (m - k)]     = er + oi;
+        spec[2 * (m - k) + 1] = -(ei - or_);
+    }
+
+    cfft(F, spec, 1);
+    if (out != spec) memcpy(out, spec, F->n * sizeof(float));
+}
+
+/*----------------------------------------------------------------------------
+ * ols_fft_size - The FFT size for 'taps': the smallest power of two
+ *   >= 2*taps, so each transform yields at least taps+1 new outputs.
+ *--------------------------------------------------------------------------*/
+static int ols_fft_size(int taps)
+{
+    int n = 4;
+    while (n < 2 * taps) n <<= 1;
+    return n;
+}
+
+size_t ols_size(int taps)
+{
+    int n = ols_fft_size(taps);
+    size_t tables = fft_table_size(n);
+
+    if (taps < 1 || tables == 0)
+    {
+        return 0;
+    }
+    return (n + 2) * sizeof(float) + tables;
+}
+
+/*----------------------------------------------------------------------------
+ * ols_init - Set up overlap-save for a filter of 'taps' coefficients.
+ *   mem: ols_size(taps) bytes, float aligned; the spectrum, then the FFT
+ *   tables.
+ *--------------------------------------------------------------------------*/
+int ols_init(struct ols_s *O, const float *filt, int taps, void *mem)
+{
+    int n = ols_fft_size(taps);
+
+    if (ols_size(taps) == 0)
+    {
+        return 0;
+    }
+
+    O->H = mem;
+    fft_init(&O->fft, n, O->H + n + 2);
+    O->taps = taps;
+    O->block = n - taps + 1;
+
+    memset(O->H, 0, (n + 2) * sizeof(float));
+    memcpy(O->H, filt, taps * sizeof(float));
+    fft_real_forward(&O->fft, O->H, O->H);
+
+    /* Fold the 2/n inverse scaling into the filter spectrum. */
+    for (int k = 0; k < n + 2; k++)
+    {
+        O->H[k] *= 2.0f / (float)n;
+    }
+    return 1;
+}
+
+size_t ols_work_size(const struct ols_s *O)
+{
+    return (O->fft.n + 2) * sizeof(float);
+}
+
+/*----------------------------------------------------------------------------
+ * ols_process - y[i] = sum of filt[k]*x[i-k], for 'count' new samples.
+ *   work: ols_work_size() bytes of the caller's
+ *--------------------------------------------------------------------------*/
+void ols_process(const struct ols_s *O, float *work, const float *hist,
+                 const float *in, float *out, int count)
+{
+    int n = O->fft.n;
+    int h = O->taps - 1;
+    float *w = work;
+
+    /* Oldest history first, then the new samples, then zero padding. */
+    for (int j = 0; j < h; j++)
+    {
+        w[j] = hist[h - 1 - j];
+    }
+    memcpy(w + h, in, count * sizeof(float));
+    memset(w + h + count, 0, (n - h - count) * sizeof(float));
+
+    fft_real_forward(&O->fft, w, w);
+
+    for (int k = 0; k <= n / 2; k++)
+    {
+        float xr = w[2 * k], xi = w[2 * k + 1];
+        float hr = O->H[2 * k], hi = O->H[2 * k + 1];
+        w[2 * k]     = xr * hr - xi * hi;
+        w[2 * k + 1] = xr * hi + xi * hr;
+    }
+
+    fft_real_inverse(&O->fft, w, w);
+
+    /* The first taps-1 outputs are corrupted by circular wrap; skip them. */
+    memcpy(out, w + h, count * sizeof(float));
+}
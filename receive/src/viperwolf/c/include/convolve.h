@@ -0,0 +1,81 @@
+// File: receive/src/viperwolf/c/include/convolve.h
+
+#ifndef CONVOLVE_H
+#define CONVOLVE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// FIR dot product: sum of data[i]*filt[i] for i in [0,taps).
+typedef float (*convolve_fn)(const float *data, const float *filt, int taps);
+
+// Lane-interleaved FIR: out[j] = sum of data[i*lanes+j]*filt[i].
+typedef void (*convolve2_fn)(const float *data, const float *filt, int taps, float out[2]);
+typedef void (*convolve4_fn)(const float *data, const float *filt, int taps, float out[4]);
+
+// Fixed-point FIR: int16 samples and coefficients, 32-bit accumulator.
+// The caller scales the coefficients so the sum cannot overflow.
+typedef int32_t (*convolve_q15_fn)(const int16_t *data, const int16_t *filt, int taps);
+
+// Channel-parallel FIR: 'lanes' (a multiple of 4) streams sharing one
+// filter, out[j] = sum of data[i*lanes+j]*filt[i]. Used by demod_multi.c.
+typedef void (*convolven_fn)(const float *data, const float *filt, int taps, int lanes, float *out);
+
+// 16-bit sample storage (demod_afsk_opts_s.half_storage): the delay line
+// holds IEEE half or bfloat16 samples, widened to float as they are loaded;
+// coefficients and sums stay float. Same lane layout as above.
+typedef float (*convolve_h_fn)(const uint16_t *data, const float *filt, int taps);
+typedef void (*convolve2_h_fn)(const uint16_t *data, const float *filt, int taps, float out[2]);
+typedef void (*convolve4_h_fn)(const uint16_t *data, const float *filt, int taps, float out[4]);
+
+// Kernels for one 16-bit format. pack() narrows n floats to the format,
+// rounding to nearest even.
+struct convolve_half_ops_s {
+    void (*pack)(const float *in, uint16_t *out, int n);
+    convolve_h_fn dot;
+    convolve2_h_fn dot2;
+    convolve4_h_fn dot4;
+};
+
+// One set of kernels for a given instruction set.
+struct convolve_ops_s {
+    const char *name;   // "scalar", "sse2", "avx2", "avx512", "neon"
+    convolve_fn dot;
+    convolve2_fn dot2;
+    convolve4_fn dot4;
+
+    // Same results for symmetric filters (filt[i]==filt[taps-1-i]), adding
+    // mirrored samples before the multiply so only half the taps are used.
+    convolve_fn dot_sym;
+    convolve2_fn dot2_sym;
+    convolve4_fn dot4_sym;
+
+    convolve_q15_fn dot_q15;
+
+    convolven_fn dotn;
+    convolven_fn dotn_sym;
+
+    struct convolve_half_ops_s f16;
+    struct convolve_half_ops_s bf16;
+
+    // Filters at least ols_min_taps and at most ols_max_taps (0: any) long
+    // are cheaper through fft.c's overlap-save (block input only).
+    // Measured against the generic dot_sym on x86; NEON assumed to behave
+    // like SSE2.
+    int ols_min_taps;
+    int ols_max_taps;
+};
+
+// Pick the fastest kernel set this CPU supports. The choice is made on the
+// first call from any thread and cached; TUNE_SIMD=<name> forces a
+// specific variant.
+const struct convolve_ops_s *convolve_select(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONVOLVE_H */
@@ -0,0 +1,1404 @@
+// File: receive/src/viperwolf/c/include/convolve_kernels.h
+//
+// Bodies of the FIR kernels behind convolve_ops_s, one set per instruction
+// set. convolve.c takes their addresses for the run-time dispatch; code
+// that knows the ISA and tap count at compile time (the specialized
+// demodulators in demod_afsk.c) calls them directly, so they inline with
+// constant trip counts. Callers must carry the matching CONVOLVE_TARGET_*.
+
+#ifndef CONVOLVE_KERNELS_H
+#define CONVOLVE_KERNELS_H
+
+#include <stdint.h>
+
+#define CONVOLVE_KERNEL static inline __attribute__((always_inline))
+
+#define CONVOLVE_TARGET_scalar
+#define CONVOLVE_TARGET_sse2   __attribute__((target("sse2")))
+#define CONVOLVE_TARGET_avx2   __attribute__((target("avx2,fma")))
+#define CONVOLVE_TARGET_avx512 __attribute__((target("avx512f,avx2,fma")))   // selected only with AVX2, FMA and F16C
+#define CONVOLVE_TARGET_f16c   __attribute__((target("avx2,fma,f16c")))         // AVX2 with the half conversions
+#define CONVOLVE_TARGET_neon
+
+#if defined(__x86_64__) || defined(__i386__)
+  #define CONVOLVE_X86 1
+  #include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) || defined(__ARM_NEON)
+  #define CONVOLVE_NEON 1
+  #include <arm_neon.h>
+#endif
+
+CONVOLVE_KERNEL float dot_scalar(const float *data, const float *filt, int taps)
+{
+    float s=0; for(int i=0;i<taps;i++){ s+=data[i]*filt[i]; } return s;
+}
+
+CONVOLVE_KERNEL void dot2_scalar(const float *data, const float *filt, int taps, float out[2])
+{
+    float s0=0,s1=0;
+    for(int i=0;i<taps;i++){
+        s0+=data[2*i]*filt[i];
+        s1+=data[2*i+1]*filt[i];
+    }
+    out[0]=s0; out[1]=s1;
+}
+
+CONVOLVE_KERNEL void dot4_scalar(const float *data, const float *filt, int taps, float out[4])
+{
+    float s0=0,s1=0,s2=0,s3=0;
+    for(int i=0;i<taps;i++){
+        s0+=data[4*i]*filt[i];
+        s1+=data[4*i+1]*filt[i];
+        s2+=data[4*i+2]*filt[i];
+        s3+=data[4*i+3]*filt[i];
+    }
+    out[0]=s0; out[1]=s1; out[2]=s2; out[3]=s3;
+}
+
+// Folded kernels for symmetric (linear-phase) filters: filt[i]==filt[taps-1-i],
+// so mirrored samples are added first and only the first half of the
+// coefficients is multiplied. Any middle tap of an odd-length filter is
+// added on its own.
+
+CONVOLVE_KERNEL float dot_sym_scalar(const float *data, const float *filt, int taps)
+{
+    const float *r=data+taps-1;
+    int h=taps/2;
+    float s=0;
+    for(int i=0;i<h;i++){ s+=(data[i]+r[-i])*filt[i]; }
+    if(taps&1) s+=data[h]*filt[h];
+    return s;
+}
+
+CONVOLVE_KERNEL void dot2_sym_scalar(const float *data, const float *filt, int taps, float out[2])
+{
+    const float *r=data+2*(taps-1);
+    int h=taps/2;
+    float s0=0,s1=0;
+    for(int i=0;i<h;i++){
+        s0+=(data[2*i]+r[-2*i])*filt[i];
+        s1+=(data[2*i+1]+r[-2*i+1])*filt[i];
+    }
+    if(taps&1){
+        s0+=data[2*h]*filt[h];
+        s1+=data[2*h+1]*filt[h];
+    }
+    out[0]=s0; out[1]=s1;
+}
+
+CONVOLVE_KERNEL void dot4_sym_scalar(const float *data, const float *filt, int taps, float out[4])
+{
+    const float *r=data+4*(taps-1);
+    int h=taps/2;
+    float s0=0,s1=0,s2=0,s3=0;
+    for(int i=0;i<h;i++){
+        s0+=(data[4*i]+r[-4*i])*filt[i];
+        s1+=(data[4*i+1]+r[-4*i+1])*filt[i];
+        s2+=(data[4*i+2]+r[-4*i+2])*filt[i];
+        s3+=(data[4*i+3]+r[-4*i+3])*filt[i];
+    }
+    if(taps&1){
+        s0+=data[4*h]*filt[h];
+        s1+=data[4*h+1]*filt[h];
+        s2+=data[4*h+2]*filt[h];
+        s3+=data[4*h+3]*filt[h];
+    }
+    out[0]=s0; out[1]=s1; out[2]=s2; out[3]=s3;
+}
+
+// Fixed-point kernel. Products are at most 2^30 and the caller's coefficient
+// scaling keeps the running sum inside 32 bits.
+CONVOLVE_KERNEL int32_t dot_q15_scalar(const int16_t *data, const int16_t *filt, int taps)
+{
+    int32_t s=0;
+    for(int i=0;i<taps;i++) s+=(int32_t)data[i]*filt[i];
+    return s;
+}
+
+// Channel-parallel FIR: 'lanes' independent streams (a multiple of 4) share
+// one filter, lane j of the sample pushed h steps ago at data[h*lanes+j].
+// The SIMD lanes span the streams, so every load feeds useful work however
+// short the filter is.
+CONVOLVE_KERNEL void dotn_scalar(const float *data, const float *filt, int taps, int lanes, float *out)
+{
+    for(int j=0;j<lanes;j++) out[j]=0.f;
+    for(int h=0;h<taps;h++){
+        const float *d=data+h*lanes;
+        float f=filt[h];
+        for(int j=0;j<lanes;j++) out[j]+=d[j]*f;
+    }
+}
+
+CONVOLVE_KERNEL void dotn_sym_scalar(const float *data, const float *filt, int taps, int lanes, float *out)
+{
+    int half=taps/2;
+    for(int j=0;j<lanes;j++) out[j]=(taps&1)?data[half*lanes+j]*filt[half]:0.f;
+    for(int h=0;h<half;h++){
+        const float *d0=data+h*lanes, *d1=data+(taps-1-h)*lanes;
+        float f=filt[h];
+        for(int j=0;j<lanes;j++) out[j]+=(d0[j]+d1[j])*f;
+    }
+}
+
+// 16-bit sample formats (convolve_half_ops_s). IEEE half has 1 sign, 5
+// exponent and 10 fraction bits, about 3 significant digits down to 6e-5
+// (subnormals below); bfloat16 is the top half of a float, full float
+// range with 8 bits of precision. Narrowing rounds to nearest even,
+// widening is exact.
+union convolve_bits_u { float f; uint32_t u; };
+
+CONVOLVE_KERNEL float f16_to_float(uint16_t h)
+{
+    union convolve_bits_u v;
+    uint32_t s=(uint32_t)(h&0x8000)<<16, e=(h>>10)&0x1f, m=h&0x3ff;
+    if(e==0x1f)  v.u=s|0x7f800000|(m<<13);                 // inf, nan
+    else if(e)   v.u=s|((e+112)<<23)|(m<<13);
+    else {
+        v.f=(float)m*(1.f/16777216.f);                      // subnormal, m*2^-24
+        v.u|=s;
+    }
+    return v.f;
+}
+
+CONVOLVE_KERNEL uint16_t float_to_f16(float f)
+{
+    union convolve_bits_u v={f};
+    uint32_t s=(v.u>>16)&0x8000, a=v.u&0x7fffffff;
+    if(a>0x7f800000) return (uint16_t)(s|0x7e00);           // nan
+    if(a>=0x477ff000) return (uint16_t)(s|0x7c00);          // 65520 and up round to inf
+    if(a>=0x38800000){                                      // normal half
+        a-=0x38000000;                                      // rebias the exponent, 127 -> 15
+        a+=0xfff+((a>>13)&1);
+        return (uint16_t)(s|(a>>13));
+    }
+    // Subnormal half: adding 0.5 leaves the value in units of 2^-24 in
+    // the low fraction bits, rounded by the FPU.
+    v.u=a;
+    v.f+=0.5f;
+    return (uint16_t)(s|(v.u-0x3f000000));
+}
+
+CONVOLVE_KERNEL float bf16_to_float(uint16_t h)
+{
+    union convolve_bits_u v;
+    v.u=(uint32_t)h<<16;
+    return v.f;
+}
+
+CONVOLVE_KERNEL uint16_t float_to_bf16(float f)
+{
+    union convolve_bits_u v={f};
+    if((v.u&0x7fffffff)>0x7f800000) return (uint16_t)((v.u>>16)|0x40);    // keep nan a nan
+    v.u+=0x7fff+((v.u>>16)&1);
+    return (uint16_t)(v.u>>16);
+}
+
+#define CONVOLVE_HALF_SCALAR(fmt)                                             \
+CONVOLVE_KERNEL void pack_##fmt##_scalar(const float *in, uint16_t *out, int n) \
+{                                                                             \
+    for(int i=0;i<n;i++) out[i]=float_to_##fmt(in[i]);                        \
+}                                                                             \
+CONVOLVE_KERNEL float dot_##fmt##_scalar(const uint16_t *data, const float *filt, int taps) \
+{                                                                             \
+    float s=0; for(int i=0;i<taps;i++){ s+=fmt##_to_float(data[i])*filt[i]; } return s; \
+}                                                                             \
+CONVOLVE_KERNEL void dot2_##fmt##_scalar(const uint16_t *data, const float *filt, int taps, float out[2]) \
+{                                                                             \
+    float s0=0,s1=0;                                                          \
+    for(int i=0;i<taps;i++){                                                  \
+        s0+=fmt##_to_float(data[2*i])*filt[i];                                \
+        s1+=fmt##_to_float(data[2*i+1])*filt[i];                              \
+    }                                                                         \
+    out[0]=s0; out[1]=s1;                                                     \
+}                                                                             \
+CONVOLVE_KERNEL void dot4_##fmt##_scalar(const uint16_t *data, const float *filt, int taps, float out[4]) \
+{                                                                             \
+    float s[4]={0,0,0,0};                                                     \
+    for(int i=0;i<taps;i++){                                                  \
+        for(int j=0;j<4;j++) s[j]+=fmt##_to_float(data[4*i+j])*filt[i];       \
+    }                                                                         \
+    out[0]=s[0]; out[1]=s[1]; out[2]=s[2]; out[3]=s[3];                       \
+}
+
+CONVOLVE_HALF_SCALAR(f16)
+CONVOLVE_HALF_SCALAR(bf16)
+
+#ifdef CONVOLVE_X86
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_sse2
+float dot_sse2(const float *data, const float *filt, int taps)
+{
+    __m128 a0=_mm_setzero_ps(), a1=_mm_setzero_ps();
+    int i=0;
+    for(; i+8<=taps; i+=8){
+        a0=_mm_add_ps(a0,_mm_mul_ps(_mm_loadu_ps(data+i),  _mm_loadu_ps(filt+i)));
+        a1=_mm_add_ps(a1,_mm_mul_ps(_mm_loadu_ps(data+i+4),_mm_loadu_ps(filt+i+4)));
+    }
+    for(; i+4<=taps; i+=4){
+        a0=_mm_add_ps(a0,_mm_mul_ps(_mm_loadu_ps(data+i),_mm_loadu_ps(filt+i)));
+    }
+    a0=_mm_add_ps(a0,a1);
+    a0=_mm_add_ps(a0,_mm_movehl_ps(a0,a0));
+    a0=_mm_add_ss(a0,_mm_shuffle_ps(a0,a0,1));
+    float s=_mm_cvtss_f32(a0);
+    for(; i<taps; i++) s+=data[i]*filt[i];
+    return s;
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_sse2
+void dot2_sse2(const float *data, const float *filt, int taps, float out[2])
+{
+    __m128 a0=_mm_setzero_ps(), a1=_mm_setzero_ps();
+    int i=0;
+    for(; i+4<=taps; i+=4){
+        __m128 f=_mm_loadu_ps(filt+i);
+        a0=_mm_add_ps(a0,_mm_mul_ps(_mm_loadu_ps(data+2*i),  _mm_unpacklo_ps(f,f)));
+        a1=_mm_add_ps(a1,_mm_mul_ps(_mm_loadu_ps(data+2*i+4),_mm_unpackhi_ps(f,f)));
+    }
+    a0=_mm_add_ps(a0,a1);
+    a0=_mm_add_ps(a0,_mm_movehl_ps(a0,a0));     // (I,Q) in lanes 0,1
+    float s[4]; _mm_storeu_ps(s,a0);
+    for(; i<taps; i++){
+        s[0]+=data[2*i]*filt[i];
+        s[1]+=data[2*i+1]*filt[i];
+    }
+    out[0]=s[0]; out[1]=s[1];
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_sse2
+void dot4_sse2(const float *data, const float *filt, int taps, float out[4])
+{
+    __m128 a0=_mm_setzero_ps(), a1=_mm_setzero_ps();
+    __m128 a2=_mm_setzero_ps(), a3=_mm_setzero_ps();
+    int i=0;
+    for(; i+4<=taps; i+=4){
+        a0=_mm_add_ps(a0,_mm_mul_ps(_mm_loadu_ps(data+4*i),   _mm_set1_ps(filt[i])));
+        a1=_mm_add_ps(a1,_mm_mul_ps(_mm_loadu_ps(data+4*i+4), _mm_set1_ps(filt[i+1])));
+        a2=_mm_add_ps(a2,_mm_mul_ps(_mm_loadu_ps(data+4*i+8), _mm_set1_ps(filt[i+2])));
+        a3=_mm_add_ps(a3,_mm_mul_ps(_mm_loadu_ps(data+4*i+12),_mm_set1_ps(filt[i+3])));
+    }
+    for(; i<taps; i++){
+        a0=_mm_add_ps(a0,_mm_mul_ps(_mm_loadu_ps(data+4*i),_mm_set1_ps(filt[i])));
+    }
+    _mm_storeu_ps(out,_mm_add_ps(_mm_add_ps(a0,a1),_mm_add_ps(a2,a3)));
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_sse2
+float dot_sym_sse2(const float *data, const float *filt, int taps)
+{
+    int h=taps/2;
+    __m128 a0=_mm_setzero_ps(), a1=_mm_setzero_ps();
+    int i=0;
+    for(; i+8<=h; i+=8){
+        __m128 r0=_mm_loadu_ps(data+taps-4-i), r1=_mm_loadu_ps(data+taps-8-i);
+        r0=_mm_shuffle_ps(r0,r0,_MM_SHUFFLE(0,1,2,3));
+        r1=_mm_shuffle_ps(r1,r1,_MM_SHUFFLE(0,1,2,3));
+        a0=_mm_add_ps(a0,_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(data+i),  r0),_mm_loadu_ps(filt+i)));
+        a1=_mm_add_ps(a1,_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(data+i+4),r1),_mm_loadu_ps(filt+i+4)));
+    }
+    a0=_mm_add_ps(a0,a1);
+    a0=_mm_add_ps(a0,_mm_movehl_ps(a0,a0));
+    a0=_mm_add_ss(a0,_mm_shuffle_ps(a0,a0,1));
+    float s=_mm_cvtss_f32(a0);
+    for(; i<h; i++) s+=(data[i]+data[taps-1-i])*filt[i];
+    if(taps&1) s+=data[h]*filt[h];
+    return s;
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_sse2
+void dot2_sym_sse2(const float *data, const float *filt, int taps, float out[2])
+{
+    int h=taps/2;
+    __m128 a0=_mm_setzero_ps(), a1=_mm_setzero_ps();
+    int i=0;
+    for(; i+4<=h; i+=4){
+        // Swap the (I,Q) pairs so the mirrored taps line up with i, i+1, ...
+        __m128 r0=_mm_loadu_ps(data+2*(taps-2-i)), r1=_mm_loadu_ps(data+2*(taps-4-i));
+        r0=_mm_shuffle_ps(r0,r0,_MM_SHUFFLE(1,0,3,2));
+        r1=_mm_shuffle_ps(r1,r1,_MM_SHUFFLE(1,0,3,2));
+        __m128 f=_mm_loadu_ps(filt+i);
+        a0=_mm_add_ps(a0,_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(data+2*i),  r0),_mm_unpacklo_ps(f,f)));
+        a1=_mm_add_ps(a1,_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(data+2*i+4),r1),_mm_unpackhi_ps(f,f)));
+    }
+    a0=_mm_add_ps(a0,a1);
+    a0=_mm_add_ps(a0,_mm_movehl_ps(a0,a0));
+    float s[4]; _mm_storeu_ps(s,a0);
+    for(; i<h; i++){
+        s[0]+=(data[2*i]+data[2*(taps-1-i)])*filt[i];
+        s[1]+=(data[2*i+1]+data[2*(taps-1-i)+1])*filt[i];
+    }
+    if(taps&1){
+        s[0]+=data[2*h]*filt[h];
+        s[1]+=data[2*h+1]*filt[h];
+    }
+    out[0]=s[0]; out[1]=s[1];
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_sse2
+void dot4_sym_sse2(const float *data, const float *filt, int taps, float out[4])
+{
+    const float *r=data+4*(taps-1);
+    int h=taps/2;
+    __m128 a0=_mm_setzero_ps(), a1=_mm_setzero_ps();
+    int i=0;
+    for(; i+2<=h; i+=2){
+        a0=_mm_add_ps(a0,_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(data+4*i),  _mm_loadu_ps(r-4*i)),  _mm_set1_ps(filt[i])));
+        a1=_mm_add_ps(a1,_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(data+4*i+4),_mm_loadu_ps(r-4*i-4)),_mm_set1_ps(filt[i+1])));
+    }
+    for(; i<h; i++){
+        a0=_mm_add_ps(a0,_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(data+4*i),_mm_loadu_ps(r-4*i)),_mm_set1_ps(filt[i])));
+    }
+    if(taps&1){
+        a1=_mm_add_ps(a1,_mm_mul_ps(_mm_loadu_ps(data+4*h),_mm_set1_ps(filt[h])));
+    }
+    _mm_storeu_ps(out,_mm_add_ps(a0,a1));
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_avx2
+float dot_avx2(const float *data, const float *filt, int taps)
+{
+    __m256 a0=_mm256_setzero_ps(), a1=_mm256_setzero_ps();
+    int i=0;
+    for(; i+16<=taps; i+=16){
+        a0=_mm256_fmadd_ps(_mm256_loadu_ps(data+i),  _mm256_loadu_ps(filt+i),  a0);
+        a1=_mm256_fmadd_ps(_mm256_loadu_ps(data+i+8),_mm256_loadu_ps(filt+i+8),a1);
+    }
+    for(; i+8<=taps; i+=8){
+        a0=_mm256_fmadd_ps(_mm256_loadu_ps(data+i),_mm256_loadu_ps(filt+i),a0);
+    }
+    a0=_mm256_add_ps(a0,a1);
+    __m128 h=_mm_add_ps(_mm256_castps256_ps128(a0),_mm256_extractf128_ps(a0,1));
+    h=_mm_add_ps(h,_mm_movehl_ps(h,h));
+    h=_mm_add_ss(h,_mm_shuffle_ps(h,h,1));
+    float s=_mm_cvtss_f32(h);
+    for(; i<taps; i++) s+=data[i]*filt[i];
+    return s;
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_avx2
+void dot2_avx2(const float *data, const float *filt, int taps, float out[2])
+{
+    const __m256i lo=_mm256_setr_epi32(0,0,1,1,2,2,3,3);
+    const __m256i hi=_mm256_setr_epi32(4,4,5,5,6,6,7,7);
+    __m256 a0=_mm256_setzero_ps(), a1=_mm256_setzero_ps();
+    int i=0;
+    for(; i+8<=taps; i+=8){
+        __m256 f=_mm256_loadu_ps(filt+i);
+        a0=_mm256_fmadd_ps(_mm256_loadu_ps(data+2*i),  _mm256_permutevar8x32_ps(f,lo),a0);
+        a1=_mm256_fmadd_ps(_mm256_loadu_ps(data+2*i+8),_mm256_permutevar8x32_ps(f,hi),a1);
+    }
+    a0=_mm256_add_ps(a0,a1);
+    __m128 h=_mm_add_ps(_mm256_castps256_ps128(a0),_mm256_extractf128_ps(a0,1));
+    h=_mm_add_ps(h,_mm_movehl_ps(h,h));
+    float s[4]; _mm_storeu_ps(s,h);
+    for(; i<taps; i++){
+        s[0]+=data[2*i]*filt[i];
+        s[1]+=data[2*i+1]*filt[i];
+    }
+    out[0]=s[0]; out[1]=s[1];
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_avx2
+void dot4_avx2(const float *data, const float *filt, int taps, float out[4])
+{
+    // Each permute spreads two taps over the four lanes of both halves.
+    const __m256i p0=_mm256_setr_epi32(0,0,0,0,1,1,1,1);
+    const __m256i p1=_mm256_setr_epi32(2,2,2,2,3,3,3,3);
+    const __m256i p2=_mm256_setr_epi32(4,4,4,4,5,5,5,5);
+    const __m256i p3=_mm256_setr_epi32(6,6,6,6,7,7,7,7);
+    __m256 a0=_mm256_setzero_ps(), a1=_mm256_setzero_ps();
+    __m256 a2=_mm256_setzero_ps(), a3=_mm256_setzero_ps();
+    int i=0;
+    for(; i+8<=taps; i+=8){
+        __m256 f=_mm256_loadu_ps(filt+i);
+        a0=_mm256_fmadd_ps(_mm256_loadu_ps(data+4*i),   _mm256_permutevar8x32_ps(f,p0),a0);
+        a1=_mm256_fmadd_ps(_mm256_loadu_ps(data+4*i+8), _mm256_permutevar8x32_ps(f,p1),a1);
+        a2=_mm256_fmadd_ps(_mm256_loadu_ps(data+4*i+16),_mm256_permutevar8x32_ps(f,p2),a2);
+        a3=_mm256_fmadd_ps(_mm256_loadu_ps(data+4*i+24),_mm256_permutevar8x32_ps(f,p3),a3);
+    }
+    a0=_mm256_add_ps(_mm256_add_ps(a0,a1),_mm256_add_ps(a2,a3));
+    __m128 h=_mm_add_ps(_mm256_castps256_ps128(a0),_mm256_extractf128_ps(a0,1));
+    for(; i<taps; i++){
+        h=_mm_fmadd_ps(_mm_loadu_ps(data+4*i),_mm_set1_ps(filt[i]),h);
+    }
+    _mm_storeu_ps(out,h);
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_avx2
+float dot_sym_avx2(const float *data, const float *filt, int taps)
+{
+    const __m256i rev=_mm256_setr_epi32(7,6,5,4,3,2,1,0);
+    int h=taps/2;
+    __m256 a0=_mm256_setzero_ps(), a1=_mm256_setzero_ps();
+    int i=0;
+    for(; i+16<=h; i+=16){
+        __m256 r0=_mm256_permutevar8x32_ps(_mm256_loadu_ps(data+taps-8-i), rev);
+        __m256 r1=_mm256_permutevar8x32_ps(_mm256_loadu_ps(data+taps-16-i),rev);
+        a0=_mm256_fmadd_ps(_mm256_add_ps(_mm256_loadu_ps(data+i),  r0),_mm256_loadu_ps(filt+i),  a0);
+        a1=_mm256_fmadd_ps(_mm256_add_ps(_mm256_loadu_ps(data+i+8),r1),_mm256_loadu_ps(filt+i+8),a1);
+    }
+    for(; i+8<=h; i+=8){
+        __m256 r0=_mm256_permutevar8x32_ps(_mm256_loadu_ps(data+taps-8-i),rev);
+        a0=_mm256_fmadd_ps(_mm256_add_ps(_mm256_loadu_ps(data+i),r0),_mm256_loadu_ps(filt+i),a0);
+    }
+    a0=_mm256_add_ps(a0,a1);
+    __m128 x=_mm_add_ps(_mm256_castps256_ps128(a0),_mm256_extractf128_ps(a0,1));
+    x=_mm_add_ps(x,_mm_movehl_ps(x,x));
+    x=_mm_add_ss(x,_mm_shuffle_ps(x,x,1));
+    float s=_mm_cvtss_f32(x);
+    for(; i<h; i++) s+=(data[i]+data[taps-1-i])*filt[i];
+    if(taps&1) s+=data[h]*filt[h];
+    return s;
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_avx2
+void dot2_sym_avx2(const float *data, const float *filt, int taps, float out[2])
+{
+    const __m256i lo=_mm256_setr_epi32(0,0,1,1,2,2,3,3);
+    const __m256i hi=_mm256_setr_epi32(4,4,5,5,6,6,7,7);
+    const __m256i rev=_mm256_setr_epi32(6,7,4,5,2,3,0,1);   // reverse taps, keep (I,Q)
+    int h=taps/2;
+    __m256 a0=_mm256_setzero_ps(), a1=_mm256_setzero_ps();
+    int i=0;
+    for(; i+8<=h; i+=8){
+        __m256 f=_mm256_loadu_ps(filt+i);
+        __m256 r0=_mm256_permutevar8x32_ps(_mm256_loadu_ps(data+2*(taps-4-i)),rev);
+        __m256 r1=_mm256_permutevar8x32_ps(_mm256_loadu_ps(data+2*(taps-8-i)),rev);
+        a0=_mm256_fmadd_ps(_mm256_add_ps(_mm256_loadu_ps(data+2*i),  r0),_mm256_permutevar8x32_ps(f,lo),a0);
+        a1=_mm256_fmadd_ps(_mm256_add_ps(_mm256_loadu_ps(data+2*i+8),r1),_mm256_permutevar8x32_ps(f,hi),a1);
+    }
+    a0=_mm256_add_ps(a0,a1);
+    __m128 x=_mm_add_ps(_mm256_castps256_ps128(a0),_mm256_extractf128_ps(a0,1));
+    x=_mm_add_ps(x,_mm_movehl_ps(x,x));
+    float s[4]; _mm_storeu_ps(s,x);
+    for(; i<h; i++){
+        s[0]+=(data[2*i]+data[2*(taps-1-i)])*filt[i];
+        s[1]+=(data[2*i+1]+data[2*(taps-1-i)+1])*filt[i];
+    }
+    if(taps&1){
+        s[0]+=data[2*h]*filt[h];
+        s[1]+=data[2*h+1]*filt[h];
+    }
+    out[0]=s[0]; out[1]=s[1];
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_avx2
+void dot4_sym_avx2(const float *data, const float *filt, int taps, float out[4])
+{
+    const __m256i p0=_mm256_setr_epi32(0,0,0,0,1,1,1,1);
+    const __m256i p1=_mm256_setr_epi32(2,2,2,2,3,3,3,3);
+    const __m256i p2=_mm256_setr_epi32(4,4,4,4,5,5,5,5);
+    const __m256i p3=_mm256_setr_epi32(6,6,6,6,7,7,7,7);
+    const float *r=data+4*(taps-1);
+    int h=taps/2;
+    __m256 a0=_mm256_setzero_ps(), a1=_mm256_setzero_ps();
+    __m256 a2=_mm256_setzero_ps(), a3=_mm256_setzero_ps();
+    int i=0;
+    for(; i+8<=h; i+=8){
+        // Two taps per register; swapping the halves of the mirrored load
+        // puts taps-1-i next to i.
+        __m256 f=_mm256_loadu_ps(filt+i);
+        __m256 r0=_mm256_loadu_ps(r-4*i-4),  r1=_mm256_loadu_ps(r-4*i-12);
+        __m256 r2=_mm256_loadu_ps(r-4*i-20), r3=_mm256_loadu_ps(r-4*i-28);
+        r0=_mm256_permute2f128_ps(r0,r0,1); r1=_mm256_permute2f128_ps(r1,r1,1);
+        r2=_mm256_permute2f128_ps(r2,r2,1); r3=_mm256_permute2f128_ps(r3,r3,1);
+        a0=_mm256_fmadd_ps(_mm256_add_ps(_mm256_loadu_ps(data+4*i),   r0),_mm256_permutevar8x32_ps(f,p0),a0);
+        a1=_mm256_fmadd_ps(_mm256_add_ps(_mm256_loadu_ps(data+4*i+8), r1),_mm256_permutevar8x32_ps(f,p1),a1);
+        a2=_mm256_fmadd_ps(_mm256_add_ps(_mm256_loadu_ps(data+4*i+16),r2),_mm256_permutevar8x32_ps(f,p2),a2);
+        a3=_mm256_fmadd_ps(_mm256_add_ps(_mm256_loadu_ps(data+4*i+24),r3),_mm256_permutevar8x32_ps(f,p3),a3);
+    }
+    a0=_mm256_add_ps(_mm256_add_ps(a0,a1),_mm256_add_ps(a2,a3));
+    __m128 x=_mm_add_ps(_mm256_castps256_ps128(a0),_mm256_extractf128_ps(a0,1));
+    for(; i<h; i++){
+        x=_mm_fmadd_ps(_mm_add_ps(_mm_loadu_ps(data+4*i),_mm_loadu_ps(r-4*i)),_mm_set1_ps(filt[i]),x);
+    }
+    if(taps&1){
+        x=_mm_fmadd_ps(_mm_loadu_ps(data+4*h),_mm_set1_ps(filt[h]),x);
+    }
+    _mm_storeu_ps(out,x);
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_avx512
+float dot_avx512(const float *data, const float *filt, int taps)
+{
+    __m512 a0=_mm512_setzero_ps(), a1=_mm512_setzero_ps();
+    int i=0;
+    for(; i+32<=taps; i+=32){
+        a0=_mm512_fmadd_ps(_mm512_loadu_ps(data+i),   _mm512_loadu_ps(filt+i),   a0);
+        a1=_mm512_fmadd_ps(_mm512_loadu_ps(data+i+16),_mm512_loadu_ps(filt+i+16),a1);
+    }
+    for(; i+16<=taps; i+=16){
+        a0=_mm512_fmadd_ps(_mm512_loadu_ps(data+i),_mm512_loadu_ps(filt+i),a0);
+    }
+    if(i<taps){
+        // Masked tail: lanes past 'taps' load as zero.
+        __mmask16 m=(__mmask16)((1u<<(taps-i))-1u);
+        a1=_mm512_fmadd_ps(_mm512_maskz_loadu_ps(m,data+i),_mm512_maskz_loadu_ps(m,filt+i),a1);
+    }
+    return _mm512_reduce_add_ps(_mm512_add_ps(a0,a1));
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_avx512
+void dot2_avx512(const float *data, const float *filt, int taps, float out[2])
+{
+    const __m512i lo=_mm512_setr_epi32(0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7);
+    const __m512i hi=_mm512_setr_epi32(8,8,9,9,10,10,11,11,12,12,13,13,14,14,15,15);
+    __m512 a0=_mm512_setzero_ps(), a1=_mm512_setzero_ps();
+    int i=0;
+    for(; i+16<=taps; i+=16){
+        __m512 f=_mm512_loadu_ps(filt+i);
+        a0=_mm512_fmadd_ps(_mm512_loadu_ps(data+2*i),   _mm512_permutexvar_ps(lo,f),a0);
+        a1=_mm512_fmadd_ps(_mm512_loadu_ps(data+2*i+16),_mm512_permutexvar_ps(hi,f),a1);
+    }
+    a0=_mm512_add_ps(a0,a1);
+    __m256 q=_mm256_add_ps(_mm512_castps512_ps256(a0),
+                           _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(a0),1)));
+    __m128 h=_mm_add_ps(_mm256_castps256_ps128(q),_mm256_extractf128_ps(q,1));
+    h=_mm_add_ps(h,_mm_movehl_ps(h,h));
+    float s[4]; _mm_storeu_ps(s,h);
+    for(; i<taps; i++){
+        s[0]+=data[2*i]*filt[i];
+        s[1]+=data[2*i+1]*filt[i];
+    }
+    out[0]=s[0]; out[1]=s[1];
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_avx512
+void dot4_avx512(const float *data, const float *filt, int taps, float out[4])
+{
+    // Each permute spreads four taps over the four lanes of every 128-bit block.
+    const __m512i p0=_mm512_setr_epi32(0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3);
+    const __m512i p1=_mm512_setr_epi32(4,4,4,4,5,5,5,5,6,6,6,6,7,7,7,7);
+    const __m512i p2=_mm512_setr_epi32(8,8,8,8,9,9,9,9,10,10,10,10,11,11,11,11);
+    const __m512i p3=_mm512_setr_epi32(12,12,12,12,13,13,13,13,14,14,14,14,15,15,15,15);
+    __m512 a0=_mm512_setzero_ps(), a1=_mm512_setzero_ps();
+    __m512 a2=_mm512_setzero_ps(), a3=_mm512_setzero_ps();
+    int i=0;
+    for(; i+16<=taps; i+=16){
+        __m512 f=_mm512_loadu_ps(filt+i);
+        a0=_mm512_fmadd_ps(_mm512_loadu_ps(data+4*i),   _mm512_permutexvar_ps(p0,f),a0);
+        a1=_mm512_fmadd_ps(_mm512_loadu_ps(data+4*i+16),_mm512_permutexvar_ps(p1,f),a1);
+        a2=_mm512_fmadd_ps(_mm512_loadu_ps(data+4*i+32),_mm512_permutexvar_ps(p2,f),a2);
+        a3=_mm512_fmadd_ps(_mm512_loadu_ps(data+4*i+48),_mm512_permutexvar_ps(p3,f),a3);
+    }
+    a0=_mm512_add_ps(_mm512_add_ps(a0,a1),_mm512_add_ps(a2,a3));
+    __m128 h=_mm_add_ps(_mm_add_ps(_mm512_extractf32x4_ps(a0,0),_mm512_extractf32x4_ps(a0,1)),
+                        _mm_add_ps(_mm512_extractf32x4_ps(a0,2),_mm512_extractf32x4_ps(a0,3)));
+    for(; i<taps; i++){
+        h=_mm_add_ps(h,_mm_mul_ps(_mm_loadu_ps(data+4*i),_mm_set1_ps(filt[i])));
+    }
+    _mm_storeu_ps(out,h);
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_avx512
+float dot_sym_avx512(const float *data, const float *filt, int taps)
+{
+    const __m512i rev=_mm512_setr_epi32(15,14,13,12,11,10,9,8,7,6,5,4,3,2,1,0);
+    int h=taps/2;
+    __m512 a0=_mm512_setzero_ps(), a1=_mm512_setzero_ps();
+    int i=0;
+    for(; i+32<=h; i+=32){
+        __m512 r0=_mm512_permutexvar_ps(rev,_mm512_loadu_ps(data+taps-16-i));
+        __m512 r1=_mm512_permutexvar_ps(rev,_mm512_loadu_ps(data+taps-32-i));
+        a0=_mm512_fmadd_ps(_mm512_add_ps(_mm512_loadu_ps(data+i),   r0),_mm512_loadu_ps(filt+i),   a0);
+        a1=_mm512_fmadd_ps(_mm512_add_ps(_mm512_loadu_ps(data+i+16),r1),_mm512_loadu_ps(filt+i+16),a1);
+    }
+    for(; i+16<=h; i+=16){
+        __m512 r0=_mm512_permutexvar_ps(rev,_mm512_loadu_ps(data+taps-16-i));
+        a0=_mm512_fmadd_ps(_mm512_add_ps(_mm512_loadu_ps(data+i),r0),_mm512_loadu_ps(filt+i),a0);
+    }
+    float s=_mm512_reduce_add_ps(_mm512_add_ps(a0,a1));
+    for(; i<h; i++) s+=(data[i]+data[taps-1-i])*filt[i];
+    if(taps&1) s+=data[h]*filt[h];
+    return s;
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_avx512
+void dot2_sym_avx512(const float *data, const float *filt, int taps, float out[2])
+{
+    const __m512i lo=_mm512_setr_epi32(0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7);
+    const __m512i hi=_mm512_setr_epi32(8,8,9,9,10,10,11,11,12,12,13,13,14,14,15,15);
+    const __m512i rev=_mm512_setr_epi32(14,15,12,13,10,11,8,9,6,7,4,5,2,3,0,1);
+    int h=taps/2;
+    __m512 a0=_mm512_setzero_ps(), a1=_mm512_setzero_ps();
+    int i=0;
+    for(; i+16<=h; i+=16){
+        __m512 f=_mm512_loadu_ps(filt+i);
+        __m512 r0=_mm512_permutexvar_ps(rev,_mm512_loadu_ps(data+2*(taps-8-i)));
+        __m512 r1=_mm512_permutexvar_ps(rev,_mm512_loadu_ps(data+2*(taps-16-i)));
+        a0=_mm512_fmadd_ps(_mm512_add_ps(_mm512_loadu_ps(data+2*i),   r0),_mm512_permutexvar_ps(lo,f),a0);
+        a1=_mm512_fmadd_ps(_mm512_add_ps(_mm512_loadu_ps(data+2*i+16),r1),_mm512_permutexvar_ps(hi,f),a1);
+    }
+    a0=_mm512_add_ps(a0,a1);
+    __m256 q=_mm256_add_ps(_mm512_castps512_ps256(a0),
+                           _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(a0),1)));
+    __m128 x=_mm_add_ps(_mm256_castps256_ps128(q),_mm256_extractf128_ps(q,1));
+    x=_mm_add_ps(x,_mm_movehl_ps(x,x));
+    float s[4]; _mm_storeu_ps(s,x);
+    for(; i<h; i++){
+        s[0]+=(data[2*i]+data[2*(taps-1-i)])*filt[i];
+        s[1]+=(data[2*i+1]+data[2*(taps-1-i)+1])*filt[i];
+    }
+    if(taps&1){
+        s[0]+=data[2*h]*filt[h];
+        s[1]+=data[2*h+1]*filt[h];
+    }
+    out[0]=s[0]; out[1]=s[1];
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_avx512
+void dot4_sym_avx512(const float *data, const float *filt, int taps, float out[4])
+{
+    const __m512i p0=_mm512_setr_epi32(0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3);
+    const __m512i p1=_mm512_setr_epi32(4,4,4,4,5,5,5,5,6,6,6,6,7,7,7,7);
+    const __m512i p2=_mm512_setr_epi32(8,8,8,8,9,9,9,9,10,10,10,10,11,11,11,11);
+    const __m512i p3=_mm512_setr_epi32(12,12,12,12,13,13,13,13,14,14,14,14,15,15,15,15);
+    const float *r=data+4*(taps-1);
+    int h=taps/2;
+    __m512 a0=_mm512_setzero_ps(), a1=_mm512_setzero_ps();
+    __m512 a2=_mm512_setzero_ps(), a3=_mm512_setzero_ps();
+    int i=0;
+    for(; i+16<=h; i+=16){
+        // Four taps per register; reversing the 128-bit blocks of the
+        // mirrored load lines taps-1-i up with i.
+        __m512 f=_mm512_loadu_ps(filt+i);
+        __m512 r0=_mm512_loadu_ps(r-4*i-12), r1=_mm512_loadu_ps(r-4*i-28);
+        __m512 r2=_mm512_loadu_ps(r-4*i-44), r3=_mm512_loadu_ps(r-4*i-60);
+        r0=_mm512_shuffle_f32x4(r0,r0,_MM_SHUFFLE(0,1,2,3));
+        r1=_mm512_shuffle_f32x4(r1,r1,_MM_SHUFFLE(0,1,2,3));
+        r2=_mm512_shuffle_f32x4(r2,r2,_MM_SHUFFLE(0,1,2,3));
+        r3=_mm512_shuffle_f32x4(r3,r3,_MM_SHUFFLE(0,1,2,3));
+        a0=_mm512_fmadd_ps(_mm512_add_ps(_mm512_loadu_ps(data+4*i),   r0),_mm512_permutexvar_ps(p0,f),a0);
+        a1=_mm512_fmadd_ps(_mm512_add_ps(_mm512_loadu_ps(data+4*i+16),r1),_mm512_permutexvar_ps(p1,f),a1);
+        a2=_mm512_fmadd_ps(_mm512_add_ps(_mm512_loadu_ps(data+4*i+32),r2),_mm512_permutexvar_ps(p2,f),a2);
+        a3=_mm512_fmadd_ps(_mm512_add_ps(_mm512_loadu_ps(data+4*i+48),r3),_mm512_permutexvar_ps(p3,f),a3);
+    }
+    a0=_mm512_add_ps(_mm512_add_ps(a0,a1),_mm512_add_ps(a2,a3));
+    __m128 x=_mm_add_ps(_mm_add_ps(_mm512_extractf32x4_ps(a0,0),_mm512_extractf32x4_ps(a0,1)),
+                        _mm_add_ps(_mm512_extractf32x4_ps(a0,2),_mm512_extractf32x4_ps(a0,3)));
+    for(; i<h; i++){
+        x=_mm_add_ps(x,_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(data+4*i),_mm_loadu_ps(r-4*i)),_mm_set1_ps(filt[i])));
+    }
+    if(taps&1){
+        x=_mm_add_ps(x,_mm_mul_ps(_mm_loadu_ps(data+4*h),_mm_set1_ps(filt[h])));
+    }
+    _mm_storeu_ps(out,x);
+}
+
+// pmaddwd multiplies 8 int16 pairs and adds neighbours into 4 int32 lanes,
+// twice the lanes of the float kernels per register.
+CONVOLVE_KERNEL CONVOLVE_TARGET_sse2
+int32_t dot_q15_sse2(const int16_t *data, const int16_t *filt, int taps)
+{
+    __m128i a0=_mm_setzero_si128(), a1=_mm_setzero_si128();
+    int i=0;
+    for(; i+16<=taps; i+=16){
+        a0=_mm_add_epi32(a0,_mm_madd_epi16(_mm_loadu_si128((const __m128i*)(data+i)),
+                                           _mm_loadu_si128((const __m128i*)(filt+i))));
+        a1=_mm_add_epi32(a1,_mm_madd_epi16(_mm_loadu_si128((const __m128i*)(data+i+8)),
+                                           _mm_loadu_si128((const __m128i*)(filt+i+8))));
+    }
+    for(; i+8<=taps; i+=8){
+        a0=_mm_add_epi32(a0,_mm_madd_epi16(_mm_loadu_si128((const __m128i*)(data+i)),
+                                           _mm_loadu_si128((const __m128i*)(filt+i))));
+    }
+    a0=_mm_add_epi32(a0,a1);
+    a0=_mm_add_epi32(a0,_mm_shuffle_epi32(a0,_MM_SHUFFLE(1,0,3,2)));
+    a0=_mm_add_epi32(a0,_mm_shuffle_epi32(a0,_MM_SHUFFLE(2,3,0,1)));
+    int32_t s=_mm_cvtsi128_si32(a0);
+    for(; i<taps; i++) s+=(int32_t)data[i]*filt[i];
+    return s;
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_avx2
+int32_t dot_q15_avx2(const int16_t *data, const int16_t *filt, int taps)
+{
+    __m256i a0=_mm256_setzero_si256(), a1=_mm256_setzero_si256();
+    int i=0;
+    for(; i+32<=taps; i+=32){
+        a0=_mm256_add_epi32(a0,_mm256_madd_epi16(_mm256_loadu_si256((const __m256i*)(data+i)),
+                                                 _mm256_loadu_si256((const __m256i*)(filt+i))));
+        a1=_mm256_add_epi32(a1,_mm256_madd_epi16(_mm256_loadu_si256((const __m256i*)(data+i+16)),
+                                                 _mm256_loadu_si256((const __m256i*)(filt+i+16))));
+    }
+    for(; i+16<=taps; i+=16){
+        a0=_mm256_add_epi32(a0,_mm256_madd_epi16(_mm256_loadu_si256((const __m256i*)(data+i)),
+                                                 _mm256_loadu_si256((const __m256i*)(filt+i))));
+    }
+    a0=_mm256_add_epi32(a0,a1);
+    __m128i h=_mm_add_epi32(_mm256_castsi256_si128(a0),_mm256_extracti128_si256(a0,1));
+    h=_mm_add_epi32(h,_mm_shuffle_epi32(h,_MM_SHUFFLE(1,0,3,2)));
+    h=_mm_add_epi32(h,_mm_shuffle_epi32(h,_MM_SHUFFLE(2,3,0,1)));
+    int32_t s=_mm_cvtsi128_si32(h);
+    for(; i<taps; i++) s+=(int32_t)data[i]*filt[i];
+    return s;
+}
+
+// The 512-bit int16 multiply-add needs AVX512BW, which avx512f alone does
+// not promise; the AVX2 kernel is already far from the bottleneck.
+#define dot_q15_avx512 dot_q15_avx2
+
+// Channel-parallel kernels (see dotn_scalar). Two accumulators alternate
+// over the taps to hide the add latency; a block of 4 lanes covers the rest.
+CONVOLVE_KERNEL CONVOLVE_TARGET_sse2
+void dotn_sse2(const float *data, const float *filt, int taps, int lanes, float *out)
+{
+    for(int j=0; j<lanes; j+=4){
+        const float *d=data+j;
+        __m128 a0=_mm_setzero_ps(), a1=_mm_setzero_ps();
+        int h=0;
+        for(; h+2<=taps; h+=2){
+            a0=_mm_add_ps(a0,_mm_mul_ps(_mm_loadu_ps(d+h*lanes),    _mm_set1_ps(filt[h])));
+            a1=_mm_add_ps(a1,_mm_mul_ps(_mm_loadu_ps(d+(h+1)*lanes),_mm_set1_ps(filt[h+1])));
+        }
+        if(h<taps) a0=_mm_add_ps(a0,_mm_mul_ps(_mm_loadu_ps(d+h*lanes),_mm_set1_ps(filt[h])));
+        _mm_storeu_ps(out+j,_mm_add_ps(a0,a1));
+    }
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_sse2
+void dotn_sym_sse2(const float *data, const float *filt, int taps, int lanes, float *out)
+{
+    int half=taps/2;
+    for(int j=0; j<lanes; j+=4){
+        const float *d=data+j;
+        __m128 a0=_mm_setzero_ps(), a1=_mm_setzero_ps();
+        int h=0;
+        for(; h+2<=half; h+=2){
+            __m128 x0=_mm_add_ps(_mm_loadu_ps(d+h*lanes),    _mm_loadu_ps(d+(taps-1-h)*lanes));
+            __m128 x1=_mm_add_ps(_mm_loadu_ps(d+(h+1)*lanes),_mm_loadu_ps(d+(taps-2-h)*lanes));
+            a0=_mm_add_ps(a0,_mm_mul_ps(x0,_mm_set1_ps(filt[h])));
+            a1=_mm_add_ps(a1,_mm_mul_ps(x1,_mm_set1_ps(filt[h+1])));
+        }
+        if(h<half){
+            __m128 x0=_mm_add_ps(_mm_loadu_ps(d+h*lanes),_mm_loadu_ps(d+(taps-1-h)*lanes));
+            a0=_mm_add_ps(a0,_mm_mul_ps(x0,_mm_set1_ps(filt[h])));
+        }
+        if(taps&1){
+            a1=_mm_add_ps(a1,_mm_mul_ps(_mm_loadu_ps(d+half*lanes),_mm_set1_ps(filt[half])));
+        }
+        _mm_storeu_ps(out+j,_mm_add_ps(a0,a1));
+    }
+}
+
+// Columns [0,cols) of a row stride of 'lanes', so AVX-512 can hand over
+// what is left after its 16-lane blocks.
+CONVOLVE_KERNEL CONVOLVE_TARGET_avx2
+void dotn_cols_avx2(const float *data, const float *filt, int taps, int lanes, int cols, float *out)
+{
+    int j=0;
+    for(; j+8<=cols; j+=8){
+        const float *d=data+j;
+        __m256 a0=_mm256_setzero_ps(), a1=_mm256_setzero_ps();
+        int h=0;
+        for(; h+2<=taps; h+=2){
+            a0=_mm256_fmadd_ps(_mm256_loadu_ps(d+h*lanes),    _mm256_set1_ps(filt[h]),  a0);
+            a1=_mm256_fmadd_ps(_mm256_loadu_ps(d+(h+1)*lanes),_mm256_set1_ps(filt[h+1]),a1);
+        }
+        if(h<taps) a0=_mm256_fmadd_ps(_mm256_loadu_ps(d+h*lanes),_mm256_set1_ps(filt[h]),a0);
+        _mm256_storeu_ps(out+j,_mm256_add_ps(a0,a1));
+    }
+    if(j<cols){
+        const float *d=data+j;
+        __m128 a0=_mm_setzero_ps();
+        for(int h=0; h<taps; h++) a0=_mm_fmadd_ps(_mm_loadu_ps(d+h*lanes),_mm_set1_ps(filt[h]),a0);
+        _mm_storeu_ps(out+j,a0);
+    }
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_avx2
+void dotn_sym_cols_avx2(const float *data, const float *filt, int taps, int lanes, int cols, float *out)
+{
+    int half=taps/2;
+    int j=0;
+    for(; j+8<=cols; j+=8){
+        const float *d=data+j;
+        __m256 a0=_mm256_setzero_ps(), a1=_mm256_setzero_ps();
+        int h=0;
+        for(; h+2<=half; h+=2){
+            __m256 x0=_mm256_add_ps(_mm256_loadu_ps(d+h*lanes),    _mm256_loadu_ps(d+(taps-1-h)*lanes));
+            __m256 x1=_mm256_add_ps(_mm256_loadu_ps(d+(h+1)*lanes),_mm256_loadu_ps(d+(taps-2-h)*lanes));
+            a0=_mm256_fmadd_ps(x0,_mm256_set1_ps(filt[h]),  a0);
+            a1=_mm256_fmadd_ps(x1,_mm256_set1_ps(filt[h+1]),a1);
+        }
+        if(h<half){
+            __m256 x0=_mm256_add_ps(_mm256_loadu_ps(d+h*lanes),_mm256_loadu_ps(d+(taps-1-h)*lanes));
+            a0=_mm256_fmadd_ps(x0,_mm256_set1_ps(filt[h]),a0);
+        }
+        if(taps&1) a1=_mm256_fmadd_ps(_mm256_loadu_ps(d+half*lanes),_mm256_set1_ps(filt[half]),a1);
+        _mm256_storeu_ps(out+j,_mm256_add_ps(a0,a1));
+    }
+    if(j<cols){
+        const float *d=data+j;
+        __m128 a0=_mm_setzero_ps();
+        for(int h=0; h<half; h++){
+            __m128 x0=_mm_add_ps(_mm_loadu_ps(d+h*lanes),_mm_loadu_ps(d+(taps-1-h)*lanes));
+            a0=_mm_fmadd_ps(x0,_mm_set1_ps(filt[h]),a0);
+        }
+        if(taps&1) a0=_mm_fmadd_ps(_mm_loadu_ps(d+half*lanes),_mm_set1_ps(filt[half]),a0);
+        _mm_storeu_ps(out+j,a0);
+    }
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_avx2
+void dotn_avx2(const float *data, const float *filt, int taps, int lanes, float *out)
+{
+    dotn_cols_avx2(data,filt,taps,lanes,lanes,out);
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_avx2
+void dotn_sym_avx2(const float *data, const float *filt, int taps, int lanes, float *out)
+{
+    dotn_sym_cols_avx2(data,filt,taps,lanes,lanes,out);
+}
+
+// 16 lanes per register, then the AVX2 code for what is left.
+CONVOLVE_KERNEL CONVOLVE_TARGET_avx512
+void dotn_avx512(const float *data, const float *filt, int taps, int lanes, float *out)
+{
+    int j=0;
+    for(; j+16<=lanes; j+=16){
+        const float *d=data+j;
+        __m512 a0=_mm512_setzero_ps(), a1=_mm512_setzero_ps();
+        int h=0;
+        for(; h+2<=taps; h+=2){
+            a0=_mm512_fmadd_ps(_mm512_loadu_ps(d+h*lanes),    _mm512_set1_ps(filt[h]),  a0);
+            a1=_mm512_fmadd_ps(_mm512_loadu_ps(d+(h+1)*lanes),_mm512_set1_ps(filt[h+1]),a1);
+        }
+        if(h<taps) a0=_mm512_fmadd_ps(_mm512_loadu_ps(d+h*lanes),_mm512_set1_ps(filt[h]),a0);
+        _mm512_storeu_ps(out+j,_mm512_add_ps(a0,a1));
+    }
+    if(j<lanes) dotn_cols_avx2(data+j,filt,taps,lanes,lanes-j,out+j);
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_avx512
+void dotn_sym_avx512(const float *data, const float *filt, int taps, int lanes, float *out)
+{
+    int half=taps/2;
+    int j=0;
+    for(; j+16<=lanes; j+=16){
+        const float *d=data+j;
+        __m512 a0=_mm512_setzero_ps(), a1=_mm512_setzero_ps();
+        int h=0;
+        for(; h+2<=half; h+=2){
+            __m512 x0=_mm512_add_ps(_mm512_loadu_ps(d+h*lanes),    _mm512_loadu_ps(d+(taps-1-h)*lanes));
+            __m512 x1=_mm512_add_ps(_mm512_loadu_ps(d+(h+1)*lanes),_mm512_loadu_ps(d+(taps-2-h)*lanes));
+            a0=_mm512_fmadd_ps(x0,_mm512_set1_ps(filt[h]),  a0);
+            a1=_mm512_fmadd_ps(x1,_mm512_set1_ps(filt[h+1]),a1);
+        }
+        if(h<half){
+            __m512 x0=_mm512_add_ps(_mm512_loadu_ps(d+h*lanes),_mm512_loadu_ps(d+(taps-1-h)*lanes));
+            a0=_mm512_fmadd_ps(x0,_mm512_set1_ps(filt[h]),a0);
+        }
+        if(taps&1) a1=_mm512_fmadd_ps(_mm512_loadu_ps(d+half*lanes),_mm512_set1_ps(filt[half]),a1);
+        _mm512_storeu_ps(out+j,_mm512_add_ps(a0,a1));
+    }
+    if(j<lanes) dotn_sym_cols_avx2(data+j,filt,taps,lanes,lanes-j,out+j);
+}
+
+// 16-bit delay lines (see float_to_f16() and friends). bfloat16 widens
+// with a shift, so SSE2 handles it; IEEE half takes F16C, which every
+// AVX2 part has, and stays scalar below that.
+#define pack_f16_sse2 pack_f16_scalar
+#define dot_f16_sse2  dot_f16_scalar
+#define dot2_f16_sse2 dot2_f16_scalar
+#define dot4_f16_sse2 dot4_f16_scalar
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_sse2
+__m128 load4_bf16_sse2(const uint16_t *p)
+{
+    return _mm_castsi128_ps(_mm_unpacklo_epi16(_mm_setzero_si128(),_mm_loadl_epi64((const __m128i *)p)));
+}
+
+// Round to nearest even on the integer bits. No nan handling in the
+// vector loop; samples never are.
+CONVOLVE_KERNEL CONVOLVE_TARGET_sse2
+void pack_bf16_sse2(const float *in, uint16_t *out, int n)
+{
+    const __m128i bias=_mm_set1_epi32(0x7fff), one=_mm_set1_epi32(1);
+    int i=0;
+    for(; i+8<=n; i+=8){
+        __m128i a=_mm_castps_si128(_mm_loadu_ps(in+i)), b=_mm_castps_si128(_mm_loadu_ps(in+i+4));
+        a=_mm_add_epi32(a,_mm_add_epi32(bias,_mm_and_si128(_mm_srli_epi32(a,16),one)));
+        b=_mm_add_epi32(b,_mm_add_epi32(bias,_mm_and_si128(_mm_srli_epi32(b,16),one)));
+        // The arithmetic shift leaves int16 values, which the signed pack
+        // passes through bit for bit.
+        _mm_storeu_si128((__m128i *)(out+i),_mm_packs_epi32(_mm_srai_epi32(a,16),_mm_srai_epi32(b,16)));
+    }
+    for(; i<n; i++) out[i]=float_to_bf16(in[i]);
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_sse2
+float dot_bf16_sse2(const uint16_t *data, const float *filt, int taps)
+{
+    __m128 a0=_mm_setzero_ps(), a1=_mm_setzero_ps();
+    int i=0;
+    for(; i+8<=taps; i+=8){
+        a0=_mm_add_ps(a0,_mm_mul_ps(load4_bf16_sse2(data+i),  _mm_loadu_ps(filt+i)));
+        a1=_mm_add_ps(a1,_mm_mul_ps(load4_bf16_sse2(data+i+4),_mm_loadu_ps(filt+i+4)));
+    }
+    a0=_mm_add_ps(a0,a1);
+    a0=_mm_add_ps(a0,_mm_movehl_ps(a0,a0));
+    a0=_mm_add_ss(a0,_mm_shuffle_ps(a0,a0,1));
+    float s=_mm_cvtss_f32(a0);
+    for(; i<taps; i++) s+=bf16_to_float(data[i])*filt[i];
+    return s;
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_sse2
+void dot2_bf16_sse2(const uint16_t *data, const float *filt, int taps, float out[2])
+{
+    __m128 a0=_mm_setzero_ps(), a1=_mm_setzero_ps();
+    int i=0;
+    for(; i+4<=taps; i+=4){
+        __m128 f=_mm_loadu_ps(filt+i);
+        a0=_mm_add_ps(a0,_mm_mul_ps(load4_bf16_sse2(data+2*i),  _mm_unpacklo_ps(f,f)));
+        a1=_mm_add_ps(a1,_mm_mul_ps(load4_bf16_sse2(data+2*i+4),_mm_unpackhi_ps(f,f)));
+    }
+    a0=_mm_add_ps(a0,a1);
+    a0=_mm_add_ps(a0,_mm_movehl_ps(a0,a0));
+    float s[4]; _mm_storeu_ps(s,a0);
+    for(; i<taps; i++){
+        s[0]+=bf16_to_float(data[2*i])*filt[i];
+        s[1]+=bf16_to_float(data[2*i+1])*filt[i];
+    }
+    out[0]=s[0]; out[1]=s[1];
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_sse2
+void dot4_bf16_sse2(const uint16_t *data, const float *filt, int taps, float out[4])
+{
+    __m128 a0=_mm_setzero_ps(), a1=_mm_setzero_ps();
+    int i=0;
+    for(; i+2<=taps; i+=2){
+        a0=_mm_add_ps(a0,_mm_mul_ps(load4_bf16_sse2(data+4*i),  _mm_set1_ps(filt[i])));
+        a1=_mm_add_ps(a1,_mm_mul_ps(load4_bf16_sse2(data+4*i+4),_mm_set1_ps(filt[i+1])));
+    }
+    if(i<taps) a0=_mm_add_ps(a0,_mm_mul_ps(load4_bf16_sse2(data+4*i),_mm_set1_ps(filt[i])));
+    _mm_storeu_ps(out,_mm_add_ps(a0,a1));
+}
+
+#define pack_bf16_avx2 pack_bf16_sse2
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_f16c
+__m256 load8_f16_avx2(const uint16_t *p)
+{
+    return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)p));
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_f16c
+__m128 load4_f16_avx2(const uint16_t *p)
+{
+    return _mm_cvtph_ps(_mm_loadl_epi64((const __m128i *)p));
+}
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_f16c
+__m256 load8_bf16_avx2(const uint16_t *p)
+{
+    __m256i x=_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)p));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(x,16));
+}
+
+#define load4_bf16_avx2 load4_bf16_sse2
+
+CONVOLVE_KERNEL CONVOLVE_TARGET_f16c
+void pack_f16_avx2(const float *in, uint16_t *out, int n)
+{
+    int i=0;
+    for(; i+8<=n; i+=8){
+        _mm_storeu_si128((__m128i *)(out+i),_mm256_cvtps_ph(_mm256_loadu_ps(in+i),_MM_FROUND_TO_NEAREST_INT));
+    }
+    for(; i<n; i++) out[i]=float_to_f16(in[i]);
+}
+
+// dot_avx2(), dot2_avx2() and dot4_avx2() widening each load.
+#define CONVOLVE_HALF_AVX2(fmt)                                               \
+CONVOLVE_KERNEL CONVOLVE_TARGET_f16c                                          \
+float dot_##fmt##_avx2(const uint16_t *data, const float *filt, int taps)    \
+{                                                                             \
+    __m256 a0=_mm256_setzero_ps(), a1=_mm256_setzero_ps();                   \
+    int i=0;                                                                  \
+    for(; i+16<=taps; i+=16){                                                 \
+        a0=_mm256_fmadd_ps(load8_##fmt##_avx2(data+i),  _mm256_loadu_ps(filt+i),  a0); \
+        a1=_mm256_fmadd_ps(load8_##fmt##_avx2(data+i+8),_mm256_loadu_ps(filt+i+8),a1); \
+    }                                                                         \
+    for(; i+8<=taps; i+=8){                                                   \
+        a0=_mm256_fmadd_ps(load8_##fmt##_avx2(data+i),_mm256_loadu_ps(filt+i),a0); \
+    }                                                                         \
+    a0=_mm256_add_ps(a0,a1);                                                  \
+    __m128 h=_mm_add_ps(_mm256_castps256_ps128(a0),_mm256_extractf128_ps(a0,1)); \
+    h=_mm_add_ps(h,_mm_movehl_ps(h,h));                                       \
+    h=_mm_add_ss(h,_mm_shuffle_ps(h,h,1));                                    \
+    float s=_mm_cvtss_f32(h);                                                 \
+    for(; i<taps; i++) s+=fmt##_to_float(data[i])*filt[i];                    \
+    return s;                                                                 \
+}                                                                             \
+                                                                              \
+CONVOLVE_KERNEL CONVOLVE_TARGET_f16c                                          \
+void dot2_##fmt##_avx2(const uint16_t *data, const float *filt, int taps, float out[2]) \
+{                                                                             \
+    const __m256i lo=_mm256_setr_epi32(0,0,1,1,2,2,3,3);                      \
+    const __m256i hi=_mm256_setr_epi32(4,4,5,5,6,6,7,7);                      \
+    __m256 a0=_mm256_setzero_ps(), a1=_mm256_setzero_ps();                   \
+    int i=0;                                                                  \
+    for(; i+8<=taps; i+=8){                                                   \
+        __m256 f=_mm256_loadu_ps(filt+i);                                     \
+        a0=_mm256_fmadd_ps(load8_##fmt##_avx2(data+2*i),  _mm256_permutevar8x32_ps(f,lo),a0); \
+        a1=_mm256_fmadd_ps(load8_##fmt##_avx2(data+2*i+8),_mm256_permutevar8x32_ps(f,hi),a1); \
+    }                                                                         \
+    a0=_mm256_add_ps(a0,a1);                                                  \
+    __m128 h=_mm_add_ps(_mm256_castps256_ps128(a0),_mm256_extractf128_ps(a0,1)); \
+    h=_mm_add_ps(h,_mm_movehl_ps(h,h));                                       \
+    float s[4]; _mm_storeu_ps(s,h);                                           \
+    for(; i<taps; i++){                                                       \
+        s[0]+=fmt##_to_float(data[2*i])*filt[i];                              \
+        s[1]+=fmt##_to_float(data[2*i+1])*filt[i];                            \
+    }                                                                         \
+    out[0]=s[0]; out[1]=s[1];                                                 \
+}                                                                             \
+                                                                              \
+CONVOLVE_KERNEL CONVOLVE_TARGET_f16c                                          \
+void dot4_##fmt##_avx2(const uint16_t *data, const float *filt, int taps, float out[4]) \
+{                                                                             \
+    const __m256i p0=_mm256_setr_epi32(0,0,0,0,1,1,1,1);                      \
+    const __m256i p1=_mm256_setr_epi32(2,2,2,2,3,3,3,3);                      \
+    const __m256i p2=_mm256_setr_epi32(4,4,4,4,5,5,5,5);                      \
+    const __m256i p3=_mm256_setr_epi32(6,6,6,6,7,7,7,7);                      \
+    __m256 a0=_mm256_setzero_ps(), a1=_mm256_setzero_ps();                   \
+    __m256 a2=_mm256_setzero_ps(), a3=_mm256_setzero_ps();                   \
+    int i=0;                                                                  \
+    for(; i+8<=taps; i+=8){                                                   \
+        __m256 f=_mm256_loadu_ps(filt+i);                                     \
+        a0=_mm256_fmadd_ps(load8_##fmt##_avx2(data+4*i),   _mm256_permutevar8x32_ps(f,p0),a0); \
+        a1=_mm256_fmadd_ps(load8_##fmt##_avx2(data+4*i+8), _mm256_permutevar8x32_ps(f,p1),a1); \
+        a2=_mm256_fmadd_ps(load8_##fmt##_avx2(data+4*i+16),_mm256_permutevar8x32_ps(f,p2),a2); \
+        a3=_mm256_fmadd_ps(load8_##fmt##_avx2(data+4*i+24),_mm256_permutevar8x32_ps(f,p3),a3); \
+    }                                                                         \
+    a0=_mm256_add_ps(_mm256_add_ps(a0,a1),_mm256_add_ps(a2,a3));              \
+    __m128 h=_mm_add_ps(_mm256_castps256_ps128(a0),_mm256_extractf128_ps(a0,1)); \
+    for(; i<taps; i++){                                                       \
+        h=_mm_fmadd_ps(load4_##fmt##_avx2(data+4*i),_mm_set1_ps(filt[i]),h);  \
+    }                                                                         \
+    _mm_storeu_ps(out,h);                                                     \
+}
+
+CONVOLVE_HALF_AVX2(f16)
+CONVOLVE_HALF_AVX2(bf16)
+
+// The AVX2 kernels are bound by the conversions, not the multiply-adds.
+#define pack_f16_avx512  pack_f16_avx2
+#define dot_f16_avx512   dot_f16_avx2
+#define dot2_f16_avx512  dot2_f16_avx2
+#define dot4_f16_avx512  dot4_f16_avx2
+#define pack_bf16_avx512 pack_bf16_avx2
+#define dot_bf16_avx512  dot_bf16_avx2
+#define dot2_bf16_avx512 dot2_bf16_avx2
+#define dot4_bf16_avx512 dot4_bf16_avx2
+
+#endif /* CONVOLVE_X86 */
+
+#ifdef CONVOLVE_NEON
+
+CONVOLVE_KERNEL float dot_neon(const float *data, const float *filt, int taps)
+{
+    float32x4_t a0=vdupq_n_f32(0.f), a1=vdupq_n_f32(0.f);
+    int i=0;
+    for(; i+8<=taps; i+=8){
+#if defined(__aarch64__)
+        a0=vfmaq_f32(a0,vld1q_f32(data+i),  vld1q_f32(filt+i));
+        a1=vfmaq_f32(a1,vld1q_f32(data+i+4),vld1q_f32(filt+i+4));
+#else
+        a0=vmlaq_f32(a0,vld1q_f32(data+i),  vld1q_f32(filt+i));
+        a1=vmlaq_f32(a1,vld1q_f32(data+i+4),vld1q_f32(filt+i+4));
+#endif
+    }
+    a0=vaddq_f32(a0,a1);
+#if defined(__aarch64__)
+    float s=vaddvq_f32(a0);
+#else
+    float32x2_t h=vadd_f32(vget_low_f32(a0),vget_high_f32(a0));
+    float s=vget_lane_f32(vpadd_f32(h,h),0);
+#endif
+    for(; i<taps; i++) s+=data[i]*filt[i];
+    return s;
+}
+
+CONVOLVE_KERNEL void dot2_neon(const float *data, const float *filt, int taps, float out[2])
+{
+    float32x4_t a0=vdupq_n_f32(0.f), a1=vdupq_n_f32(0.f);
+    int i=0;
+    for(; i+4<=taps; i+=4){
+        float32x2_t f01=vld1_f32(filt+i), f23=vld1_f32(filt+i+2);
+        float32x4_t fa=vcombine_f32(vdup_lane_f32(f01,0),vdup_lane_f32(f01,1));
+        float32x4_t fb=vcombine_f32(vdup_lane_f32(f23,0),vdup_lane_f32(f23,1));
+#if defined(__aarch64__)
+        a0=vfmaq_f32(a0,vld1q_f32(data+2*i),  fa);
+        a1=vfmaq_f32(a1,vld1q_f32(data+2*i+4),fb);
+#else
+        a0=vmlaq_f32(a0,vld1q_f32(data+2*i),  fa);
+        a1=vmlaq_f32(a1,vld1q_f32(data+2*i+4),fb);
+#endif
+    }
+    a0=vaddq_f32(a0,a1);
+    float32x2_t h=vadd_f32(vget_low_f32(a0),vget_high_f32(a0));
+    float s0=vget_lane_f32(h,0), s1=vget_lane_f32(h,1);
+    for(; i<taps; i++){
+        s0+=data[2*i]*filt[i];
+        s1+=data[2*i+1]*filt[i];
+    }
+    out[0]=s0; out[1]=s1;
+}
+
+CONVOLVE_KERNEL void dot4_neon(const float *data, const float *filt, int taps, float out[4])
+{
+    float32x4_t a0=vdupq_n_f32(0.f), a1=vdupq_n_f32(0.f);
+    int i=0;
+    for(; i+2<=taps; i+=2){
+#if defined(__aarch64__)
+        a0=vfmaq_n_f32(a0,vld1q_f32(data+4*i),  filt[i]);
+        a1=vfmaq_n_f32(a1,vld1q_f32(data+4*i+4),filt[i+1]);
+#else
+        a0=vmlaq_n_f32(a0,vld1q_f32(data+4*i),  filt[i]);
+        a1=vmlaq_n_f32(a1,vld1q_f32(data+4*i+4),filt[i+1]);
+#endif
+    }
+    for(; i<taps; i++){
+        a0=vmlaq_n_f32(a0,vld1q_f32(data+4*i),filt[i]);
+    }
+    vst1q_f32(out,vaddq_f32(a0,a1));
+}
+
+CONVOLVE_KERNEL float32x4_t neon_rev4(float32x4_t v)
+{
+    v=vrev64q_f32(v);                                   // 1,0,3,2
+    return vcombine_f32(vget_high_f32(v),vget_low_f32(v)); // 3,2,1,0
+}
+
+CONVOLVE_KERNEL float dot_sym_neon(const float *data, const float *filt, int taps)
+{
+    int h=taps/2;
+    float32x4_t a0=vdupq_n_f32(0.f), a1=vdupq_n_f32(0.f);
+    int i=0;
+    for(; i+8<=h; i+=8){
+        float32x4_t r0=neon_rev4(vld1q_f32(data+taps-4-i));
+        float32x4_t r1=neon_rev4(vld1q_f32(data+taps-8-i));
+        a0=vmlaq_f32(a0,vaddq_f32(vld1q_f32(data+i),  r0),vld1q_f32(filt+i));
+        a1=vmlaq_f32(a1,vaddq_f32(vld1q_f32(data+i+4),r1),vld1q_f32(filt+i+4));
+    }
+    a0=vaddq_f32(a0,a1);
+    float32x2_t x=vadd_f32(vget_low_f32(a0),vget_high_f32(a0));
+    float s=vget_lane_f32(vpadd_f32(x,x),0);
+    for(; i<h; i++) s+=(data[i]+data[taps-1-i])*filt[i];
+    if(taps&1) s+=data[h]*filt[h];
+    return s;
+}
+
+CONVOLVE_KERNEL void dot2_sym_neon(const float *data, const float *filt, int taps, float out[2])
+{
+    int h=taps/2;
+    float32x4_t a0=vdupq_n_f32(0.f), a1=vdupq_n_f32(0.f);
+    int i=0;
+    for(; i+4<=h; i+=4){
+        // Swap the (I,Q) pairs so the mirrored taps line up with i, i+1, ...
+        float32x4_t r0=vld1q_f32(data+2*(taps-2-i)), r1=vld1q_f32(data+2*(taps-4-i));
+        r0=vcombine_f32(vget_high_f32(r0),vget_low_f32(r0));
+        r1=vcombine_f32(vget_high_f32(r1),vget_low_f32(r1));
+        float32x2_t f01=vld1_f32(filt+i), f23=vld1_f32(filt+i+2);
+        float32x4_t fa=vcombine_f32(vdup_lane_f32(f01,0),vdup_lane_f32(f01,1));
+        float32x4_t fb=vcombine_f32(vdup_lane_f32(f23,0),vdup_lane_f32(f23,1));
+        a0=vmlaq_f32(a0,vaddq_f32(vld1q_f32(data+2*i),  r0),fa);
+        a1=vmlaq_f32(a1,vaddq_f32(vld1q_f32(data+2*i+4),r1),fb);
+    }
+    a0=vaddq_f32(a0,a1);
+    float32x2_t x=vadd_f32(vget_low_f32(a0),vget_high_f32(a0));
+    float s0=vget_lane_f32(x,0), s1=vget_lane_f32(x,1);
+    for(; i<h; i++){
+        s0+=(data[2*i]+data[2*(taps-1-i)])*filt[i];
+        s1+=(data[2*i+1]+data[2*(taps-1-i)+1])*filt[i];
+    }
+    if(taps&1){
+        s0+=data[2*h]*filt[h];
+        s1+=data[2*h+1]*filt[h];
+    }
+    out[0]=s0; out[1]=s1;
+}
+
+CONVOLVE_KERNEL void dot4_sym_neon(const float *data, const float *filt, int taps, float out[4])
+{
+    const float *r=data+4*(taps-1);
+    int h=taps/2;
+    float32x4_t a0=vdupq_n_f32(0.f), a1=vdupq_n_f32(0.f);
+    int i=0;
+    for(; i+2<=h; i+=2){
+        a0=vmlaq_n_f32(a0,vaddq_f32(vld1q_f32(data+4*i),  vld1q_f32(r-4*i)),  filt[i]);
+        a1=vmlaq_n_f32(a1,vaddq_f32(vld1q_f32(data+4*i+4),vld1q_f32(r-4*i-4)),filt[i+1]);
+    }
+    for(; i<h; i++){
+        a0=vmlaq_n_f32(a0,vaddq_f32(vld1q_f32(data+4*i),vld1q_f32(r-4*i)),filt[i]);
+    }
+    if(taps&1){
+        a1=vmlaq_n_f32(a1,vld1q_f32(data+4*h),filt[h]);
+    }
+    vst1q_f32(out,vaddq_f32(a0,a1));
+}
+
+CONVOLVE_KERNEL int32_t dot_q15_neon(const int16_t *data, const int16_t *filt, int taps)
+{
+    int32x4_t a0=vdupq_n_s32(0), a1=vdupq_n_s32(0);
+    int i=0;
+    for(; i+8<=taps; i+=8){
+        int16x8_t d=vld1q_s16(data+i), f=vld1q_s16(filt+i);
+        a0=vmlal_s16(a0,vget_low_s16(d), vget_low_s16(f));
+        a1=vmlal_s16(a1,vget_high_s16(d),vget_high_s16(f));
+    }
+    a0=vaddq_s32(a0,a1);
+#if defined(__aarch64__)
+    int32_t s=vaddvq_s32(a0);
+#else
+    int32x2_t h=vadd_s32(vget_low_s32(a0),vget_high_s32(a0));
+    int32_t s=vget_lane_s32(vpadd_s32(h,h),0);
+#endif
+    for(; i<taps; i++) s+=(int32_t)data[i]*filt[i];
+    return s;
+}
+
+CONVOLVE_KERNEL float32x4_t neon_fma(float32x4_t a, float32x4_t b, float32x4_t c)
+{
+#if defined(__aarch64__)
+    return vfmaq_f32(a,b,c);
+#else
+    return vmlaq_f32(a,b,c);
+#endif
+}
+
+CONVOLVE_KERNEL void dotn_neon(const float *data, const float *filt, int taps, int lanes, float *out)
+{
+    for(int j=0; j<lanes; j+=4){
+        const float *d=data+j;
+        float32x4_t a0=vdupq_n_f32(0.f), a1=vdupq_n_f32(0.f);
+        int h=0;
+        for(; h+2<=taps; h+=2){
+            a0=neon_fma(a0,vld1q_f32(d+h*lanes),    vdupq_n_f32(filt[h]));
+            a1=neon_fma(a1,vld1q_f32(d+(h+1)*lanes),vdupq_n_f32(filt[h+1]));
+        }
+        if(h<taps) a0=neon_fma(a0,vld1q_f32(d+h*lanes),vdupq_n_f32(filt[h]));
+        vst1q_f32(out+j,vaddq_f32(a0,a1));
+    }
+}
+
+CONVOLVE_KERNEL void dotn_sym_neon(const float *data, const float *filt, int taps, int lanes, float *out)
+{
+    int half=taps/2;
+    for(int j=0; j<lanes; j+=4){
+        const float *d=data+j;
+        float32x4_t a0=vdupq_n_f32(0.f), a1=vdupq_n_f32(0.f);
+        for(int h=0; h<half; h++){
+            float32x4_t x=vaddq_f32(vld1q_f32(d+h*lanes),vld1q_f32(d+(taps-1-h)*lanes));
+            if(h&1) a1=neon_fma(a1,x,vdupq_n_f32(filt[h]));
+            else    a0=neon_fma(a0,x,vdupq_n_f32(filt[h]));
+        }
+        if(taps&1) a1=neon_fma(a1,vld1q_f32(d+half*lanes),vdupq_n_f32(filt[half]));
+        vst1q_f32(out+j,vaddq_f32(a0,a1));
+    }
+}
+
+// 16-bit delay lines. bfloat16 widens with a shift; IEEE half needs the
+// half-precision conversions, which ARMv7 only has with an fp16 FPU.
+#if defined(__aarch64__) || (defined(__ARM_FP) && (__ARM_FP & 2))
+CONVOLVE_KERNEL float32x4_t load4_f16_neon(const uint16_t *p)
+{
+    return vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(p)));
+}
+
+CONVOLVE_KERNEL void pack_f16_neon(const float *in, uint16_t *out, int n)
+{
+    int i=0;
+    for(; i+4<=n; i+=4) vst1_u16(out+i,vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(in+i))));
+    for(; i<n; i++) out[i]=float_to_f16(in[i]);
+}
+#define CONVOLVE_NEON_F16 1
+#else
+#define pack_f16_neon pack_f16_scalar
+#define dot_f16_neon  dot_f16_scalar
+#define dot2_f16_neon dot2_f16_scalar
+#define dot4_f16_neon dot4_f16_scalar
+#endif
+
+CONVOLVE_KERNEL float32x4_t load4_bf16_neon(const uint16_t *p)
+{
+    return vreinterpretq_f32_u32(vshll_n_u16(vld1_u16(p),16));
+}
+
+// Round to nearest even on the integer bits, as pack_bf16_sse2().
+CONVOLVE_KERNEL void pack_bf16_neon(const float *in, uint16_t *out, int n)
+{
+    const uint32x4_t bias=vdupq_n_u32(0x7fff), one=vdupq_n_u32(1);
+    int i=0;
+    for(; i+4<=n; i+=4){
+        uint32x4_t u=vreinterpretq_u32_f32(vld1q_f32(in+i));
+        u=vaddq_u32(u,vaddq_u32(bias,vandq_u32(vshrq_n_u32(u,16),one)));
+        vst1_u16(out+i,vshrn_n_u32(u,16));
+    }
+    for(; i<n; i++) out[i]=float_to_bf16(in[i]);
+}
+
+// dot_neon(), dot2_neon() and dot4_neon() widening each load.
+#define CONVOLVE_HALF_NEON(fmt)                                               \
+CONVOLVE_KERNEL float dot_##fmt##_neon(const uint16_t *data, const float *filt, int taps) \
+{                                                                             \
+    float32x4_t a0=vdupq_n_f32(0.f), a1=vdupq_n_f32(0.f);                     \
+    int i=0;                                                                  \
+    for(; i+8<=taps; i+=8){                                                   \
+        a0=neon_fma(a0,load4_##fmt##_neon(data+i),  vld1q_f32(filt+i));       \
+        a1=neon_fma(a1,load4_##fmt##_neon(data+i+4),vld1q_f32(filt+i+4));     \
+    }                                                                         \
+    a0=vaddq_f32(a0,a1);                                                      \
+    float32x2_t h=vadd_f32(vget_low_f32(a0),vget_high_f32(a0));               \
+    float s=vget_lane_f32(vpadd_f32(h,h),0);                                  \
+    for(; i<taps; i++) s+=fmt##_to_float(data[i])*filt[i];                    \
+    return s;                                                                 \
+}                                                                             \
+                                                                              \
+CONVOLVE_KERNEL void dot2_##fmt##_neon(const uint16_t *data, const float *filt, int taps, float out[2]) \
+{                                                                             \
+    float32x4_t a0=vdupq_n_f32(0.f), a1=vdupq_n_f32(0.f);                     \
+    int i=0;                                                                  \
+    for(; i+4<=taps; i+=4){                                                   \
+        float32x2_t f01=vld1_f32(filt+i), f23=vld1_f32(filt+i+2);             \
+        float32x4_t fa=vcombine_f32(vdup_lane_f32(f01,0),vdup_lane_f32(f01,1)); \
+        float32x4_t fb=vcombine_f32(vdup_lane_f32(f23,0),vdup_lane_f32(f23,1)); \
+        a0=neon_fma(a0,load4_##fmt##_neon(data+2*i),  fa);                    \
+        a1=neon_fma(a1,load4_##fmt##_neon(data+2*i+4),fb);                    \
+    }                                                                         \
+    a0=vaddq_f32(a0,a1);                                                      \
+    float32x2_t h=vadd_f32(vget_low_f32(a0),vget_high_f32(a0));               \
+    float s0=vget_lane_f32(h,0), s1=vget_lane_f32(h,1);                       \
+    for(; i<taps; i++){                                                       \
+        s0+=fmt##_to_float(data[2*i])*filt[i];                                \
+        s1+=fmt##_to_float(data[2*i+1])*filt[i];                              \
+    }                                                                         \
+    out[0]=s0; out[1]=s1;                                                     \
+}                                                                             \
+                                                                              \
+CONVOLVE_KERNEL void dot4_##fmt##_neon(const uint16_t *data, const float *filt, int taps, float out[4]) \
+{                                                                             \
+    float32x4_t a0=vdupq_n_f32(0.f), a1=vdupq_n_f32(0.f);                     \
+    int i=0;                                                                  \
+    for(; i+2<=taps; i+=2){                                                   \
+        a0=neon_fma(a0,load4_##fmt##_neon(data+4*i),  vdupq_n_f32(filt[i]));  \
+        a1=neon_fma(a1,load4_##fmt##_neon(data+4*i+4),vdupq_n_f32(filt[i+1])); \
+    }                                                                         \
+    if(i<taps) a0=neon_fma(a0,load4_##fmt##_neon(data+4*i),vdupq_n_f32(filt[i])); \
+    vst1q_f32(out,vaddq_f32(a0,a1));                                          \
+}
+
+#ifdef CONVOLVE_NEON_F16
+CONVOLVE_HALF_NEON(f16)
+#endif
+CONVOLVE_HALF_NEON(bf16)
+
+#endif /* CONVOLVE_NEON */
+
+#endif /* CONVOLVE_KERNELS_H */
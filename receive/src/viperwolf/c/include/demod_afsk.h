@@ -18,7 +18,103 @@
 extern "C" {
 #endif
 
-// Initialize the AFSK demodulator:
+// Profile B/D frequency discriminator, see demod_afsk_opts_s.fm_disc.
+enum fm_disc_e {
+    FM_DISC_ATAN2=0,    // atan2f() of each sample, unwrap the difference
+    FM_DISC_CONJ,       // polynomial atan2 of z[n]*conj(z[n-1]), no unwrap
+    FM_DISC_CROSS       // cross/dot of z[n] and z[n-1]: no arctangent at all
+};
+
+// Block-input prefilter, see demod_afsk_opts_s.fast_conv.
+enum fast_conv_e {
+    FAST_CONV_OFF=0,    // direct FIR, the same bits as per-sample input
+    FAST_CONV_AUTO,     // overlap-save FFT past this CPU's break-even
+    FAST_CONV_ALWAYS    // overlap-save FFT at any length
+};
+
+// Delay-line sample format, see demod_afsk_opts_s.half_storage.
+enum half_storage_e {
+    HALF_STORAGE_NONE=0,    // float
+    HALF_STORAGE_F16,       // IEEE half: 11 significant bits
+    HALF_STORAGE_BF16       // bfloat16: 8 significant bits, float's range
+};
+
+// Per-instance options for demod_afsk_init_opts().
+struct demod_afsk_opts_s {
+    // Compute the lowpass output and run AGC/PLL only every Nth sample.
+    // 1 = off, 0 = largest factor that keeps 16 samples per symbol.
+    int decimate;
+
+    // Prefilter on block input, a fast_conv_e value. Overlap-save rounds
+    // differently from the direct FIR, so block output then no longer
+    // matches per-sample output bit for bit.
+    int fast_conv;
+
+    // 1 = run the whole chain in Q15 fixed point (int16 samples and
+    // coefficients, 32-bit accumulators, integer AGC/PLL). No FPU needed
+    // past init; bits differ slightly from the float path.
+    int fixed_point;
+
+    // Profile B/D discriminator, an fm_disc_e value. FM_DISC_CROSS reads
+    // sin() of the phase step, which is close enough while the step stays
+    // well inside +/-90 degrees (true for AFSK even with decimation).
+    // The fixed-point path always uses its binary-angle atan2.
+    int fm_disc;
+
+    // Bandpass prefilter: IIR_NONE = FIR (linear phase), IIR_BUTTERWORTH
+    // or IIR_CHEBYSHEV = 6-pole biquad cascade with the same band edges,
+    // about 30 flops per sample instead of one multiply-add per FIR tap,
+    // with nonlinear phase. Float path only; the fixed-point path keeps
+    // the FIR.
+    int prefilter_iir;
+
+    // Prefilter (and the lowpass when it is not the RRC) sized from a spec
+    // instead of each profile's fixed length: FILTER_DESIGN_FIXED (the
+    // default), FILTER_DESIGN_KAISER or FILTER_DESIGN_EQUIRIPPLE, with
+    // filter_atten_db of stopband attenuation. The transition widths are
+    // per profile. Fewer taps for the same rejection, but no
+    // specialization matches them, so block input is not always faster.
+    int filter_design;
+    float filter_atten_db;
+
+    // 1 = minimum-phase prefilter and lowpass (make_min_phase() in dsp.c):
+    // same magnitude response, but bit decisions come out earlier (the
+    // linear-phase filters delay everything by half their length). The
+    // phase response is no longer linear, so bit errors rise a little.
+    // Costs CPU on all input: the filters lose the folded kernels and the
+    // specializations.
+    int low_latency;
+
+    // Float-path delay lines in 16 bits, a half_storage_e value: half the
+    // cache footprint per instance, for many channels per core. Samples
+    // are rounded as they are pushed and widened as the FIR loads them;
+    // coefficients and arithmetic stay float. Uses the unfolded kernels,
+    // the direct-form prefilter and no specialization. Profiles A, B and
+    // C; fixed_point, profile G and demod_multi ignore it.
+    int half_storage;
+
+    // Block kernels specialized at compile time for the standard rates and
+    // tap counts: 0 = use one when it matches, -1 = always generic.
+    int specialize;
+
+    // Slicers on the demodulator output (1..MAX_SLICERS). Slicer 0 decides
+    // at 0; the others at +step, -step, +2*step... (step = SLICER_STEP in
+    // demod_afsk.c) with the profile's PLL inertias, see
+    // demod_afsk_set_slicer() to change them. In profile C slicers 1 and 2
+    // decide at 0 on the A and B detectors alone, and the steps start at 3.
+    // Each one enabled here gets a bit queue (about 1 KB) in the instance.
+    int num_slicers;
+};
+
+// Fill in the defaults (TUNE_* environment variables override them):
+void demod_afsk_default_opts(struct demod_afsk_opts_s *opts);
+
+// Profiles: 'A'/'E' two-tone envelope detector, 'B'/'D' FM discriminator,
+// 'C' both on one prefilter, slicing their weighted mean, 'G' sliding DFT
+// at the two tones (least CPU, no filters). C and G are float only;
+// fixed_point is ignored.
+
+// Initialize the AFSK demodulator with default options:
 void demod_afsk_init(int samples_per_sec,
                      int baud,
                      int mark_freq,
@@ -26,12 +122,114 @@ void demod_afsk_init(int samples_per_sec,
                      char profile,
                      struct demodulator_state_s *D);
 
+// Initialize the AFSK demodulator with explicit options. D must be zeroed
+// (create_demodulator_state() returns it so) or initialized before: both
+// init functions allocate the delay lines sized to this configuration and
+// free those of the previous one. The filters come from a cache shared by
+// all instances with the same settings and TUNE_* environment, so they
+// are designed once while any such instance exists.
+void demod_afsk_init_opts(int samples_per_sec,
+                          int baud,
+                          int mark_freq,
+                          int space_freq,
+                          char profile,
+                          const struct demod_afsk_opts_s *opts,
+                          struct demodulator_state_s *D);
+
+// The settings and a reference to the shared filters, without the
+// per-instance arrays: for engines that keep their own state
+// (demod_multi.c). D cannot process samples. demod_afsk_release() drops
+// the reference.
+void demod_afsk_init_config(int samples_per_sec,
+                            int baud,
+                            int mark_freq,
+                            int space_freq,
+                            char profile,
+                            const struct demod_afsk_opts_s *opts,
+                            struct demodulator_state_s *D);
+
+// Bytes one instance with these settings takes when initialized with
+// demod_afsk_init_in(): the state followed by its arrays. Designs the
+// filters to find out unless they are cached.
+size_t demod_afsk_state_size(int samples_per_sec,
+                             int baud,
+                             int mark_freq,
+                             int space_freq,
+                             char profile,
+                             const struct demod_afsk_opts_s *opts);
+
+// Initialize an instance in caller memory: 'mem' 64-byte aligned and
+// 'size' at least demod_afsk_state_size() for the same arguments. Nothing
+// is allocated but the shared filters, which demod_afsk_release() gives
+// back. Returns the state (at mem), or NULL if mem is misaligned or too
+// small.
+struct demodulator_state_s *demod_afsk_init_in(void *mem,
+                                               size_t size,
+                                               int samples_per_sec,
+                                               int baud,
+                                               int mark_freq,
+                                               int space_freq,
+                                               char profile,
+                                               const struct demod_afsk_opts_s *opts);
+
+// Copy initialized instance 'src', state and arrays, into caller memory as
+// for demod_afsk_init_in() ('size' as for src's settings). Much cheaper
+// than an init; the copy shares src's filters and needs
+// demod_afsk_release() like any other instance. Returns it, or NULL.
+struct demodulator_state_s *demod_afsk_copy_in(void *mem,
+                                               size_t size,
+                                               const struct demodulator_state_s *src);
+
+// Free the arrays demod_afsk_init()/demod_afsk_init_opts() allocated for D
+// and drop its reference to the shared filters (free_demodulator_state()
+// does it too). After demod_afsk_init_in() or demod_afsk_copy_in() only
+// the reference is dropped.
+void demod_afsk_release(struct demodulator_state_s *D);
+
+// Set slicer 'slicer' (0..MAX_SLICERS-1) to decide at 'threshold' on the
+// demodulator output (about +/-1 at the mark and space tones) with the
+// given PLL inertias, and enable it and all below it. Call after init;
+// returns 0 if slicer is out of range. Init gives opts->num_slicers
+// slicers a bit queue; past those, a state from demod_afsk_init*() gets
+// its arrays reallocated (queues taken before become invalid, and no
+// other thread may be using D), while one in caller memory
+// (demod_afsk_init_in(), demod_afsk_copy_in(), pools) returns 0.
+int demod_afsk_set_slicer(struct demodulator_state_s *D,
+                          int slicer,
+                          float threshold,
+                          float locked_inertia,
+                          float searching_inertia);
+
+// The bit queue of slicer 'slicer', see my_fsk.h: the thread processing
+// samples for D puts, one other thread may take. NULL if slicer has no
+// queue (see demod_afsk_set_slicer()).
+struct my_fsk_queue_s *demod_afsk_queue(struct demodulator_state_s *D, int slicer);
+
+// Drop the bits waiting in all of D's queues (consumer side).
+void demod_afsk_clear_bits(struct demodulator_state_s *D);
+
 // Process a single audio sample:
 void demod_afsk_process_sample(int chan,
                                int subchan,
                                int sam,
                                struct demodulator_state_s *D);
 
+// Process a contiguous block of 16-bit samples (same scale as 'sam' above).
+// The bits are those of demod_afsk_process_sample() on each sample, unless
+// opts->fast_conv put the prefilter on overlap-save:
+void demod_afsk_process_block_s16(int chan,
+                                  int subchan,
+                                  const int16_t *samples,
+                                  int count,
+                                  struct demodulator_state_s *D);
+
+// Process a contiguous block of float samples, full scale = +/-1.0:
+void demod_afsk_process_block_f32(int chan,
+                                  int subchan,
+                                  const float *samples,
+                                  int count,
+                                  struct demodulator_state_s *D);
+
 #ifdef __cplusplus
 }
 #endif
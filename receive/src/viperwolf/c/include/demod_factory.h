@@ -0,0 +1,73 @@
+// File: receive/src/viperwolf/c/include/demod_factory.h
+//
+// Allocation of demodulator instances: one at a time from the heap, or
+// many from a pool. A pool is one contiguous mapping holding N instances
+// of the same configuration side by side. Slots are handed out and taken
+// back with a free list, so once the pool exists, spinning channels up and
+// down never reaches the system allocator and every state stays in the
+// same few (optionally huge) pages.
+
+#ifndef DEMOD_FACTORY_H
+#define DEMOD_FACTORY_H
+
+#include <stddef.h>
+#include "demod_afsk.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Zeroed, cache-line aligned state for demod_afsk_init(). NULL if out of
+// memory.
+struct demodulator_state_s *create_demodulator_state(void);
+
+// Free a state from create_demodulator_state(), arrays included.
+void free_demodulator_state(struct demodulator_state_s *p);
+
+struct demod_pool_s;
+
+// demod_pool_create() flags:
+#define DEMOD_POOL_HUGEPAGES 1  // back the pool with huge pages if possible
+
+// Pool of 'count' instances of one configuration (as demod_afsk_init_opts();
+// opts may be NULL for the defaults). The filters are designed here, not
+// per instance.
+// Returns NULL on bad arguments (profile, rates, tones past Nyquist) or if
+// the pool cannot be allocated. Running out of memory while designing the
+// filters exits, as in demod_afsk_init().
+struct demod_pool_s *demod_pool_create(int count,
+                                       int samples_per_sec,
+                                       int baud,
+                                       int mark_freq,
+                                       int space_freq,
+                                       char profile,
+                                       const struct demod_afsk_opts_s *opts,
+                                       int flags);
+
+// Unmap the pool. Its instances must no longer be in use.
+void demod_pool_free(struct demod_pool_s *P);
+
+// A freshly initialized instance, as demod_afsk_init_opts() would leave it,
+// or NULL if all slots are taken. Safe to call from any thread.
+struct demodulator_state_s *demod_pool_get(struct demod_pool_s *P);
+
+// Give back an instance from demod_pool_get() of the same pool. Pointers
+// that are not, and slots already given back, are ignored.
+void demod_pool_put(struct demod_pool_s *P, struct demodulator_state_s *D);
+
+// Slots not handed out.
+int demod_pool_available(struct demod_pool_s *P);
+
+// Bytes per slot, a multiple of the cache line.
+size_t demod_pool_slot_size(const struct demod_pool_s *P);
+
+// 1 if the mapping got huge pages: explicit ones (MAP_HUGETLB), or
+// transparent ones requested with madvise() that /proc/self/smaps shows
+// in it once faulted in. 0 otherwise.
+int demod_pool_hugepages(const struct demod_pool_s *P);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DEMOD_FACTORY_H */
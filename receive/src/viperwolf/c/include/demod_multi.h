@@ -0,0 +1,65 @@
+// File: receive/src/viperwolf/c/include/demod_multi.h
+//
+// Several audio channels through one demodulator, struct-of-arrays: every
+// per-channel value is an array indexed by channel, so the FIR kernels,
+// AGC and PLL each run one SIMD lane per channel instead of looping over
+// channels. All channels share one modem configuration (rate, baud, tones,
+// profile, options). Bits of channel j go to demod_multi_queue(M, j).
+//
+// Channels are padded to a multiple of 4 and the gain comes from filling
+// wide vectors: for one or two channels, or without AVX2, separate
+// demod_afsk.c instances are as fast or faster.
+
+#ifndef DEMOD_MULTI_H
+#define DEMOD_MULTI_H
+
+#include <stdint.h>
+#include "demod_afsk.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct demod_multi_s;
+
+// Allocate and initialize an engine for 'num_chans' channels
+// (1..MAX_CHANS). opts may be NULL for the defaults; the engine is float
+// only, FIR prefiltered and keeps float delay lines, so opts->fixed_point,
+// opts->prefilter_iir and opts->half_storage are ignored. It has one
+// slicer per channel and its own direct-form kernels, so opts->num_slicers,
+// opts->fast_conv and opts->specialize are ignored too. Profiles A/E and
+// B/D only.
+// Returns NULL on bad arguments or out of memory.
+struct demod_multi_s *demod_multi_create(int num_chans,
+                                         int samples_per_sec,
+                                         int baud,
+                                         int mark_freq,
+                                         int space_freq,
+                                         char profile,
+                                         const struct demod_afsk_opts_s *opts);
+
+void demod_multi_free(struct demod_multi_s *M);
+
+int demod_multi_num_chans(const struct demod_multi_s *M);
+
+// The bit queue of channel 'chan' (see my_fsk.h), NULL if out of range.
+// The engine puts from the thread calling demod_multi_process_*(); one
+// other thread may take.
+struct my_fsk_queue_s *demod_multi_queue(struct demod_multi_s *M, int chan);
+
+// Process 'count' frames of interleaved 16-bit audio, num_chans samples
+// per frame (the layout multi-channel sound cards deliver):
+void demod_multi_process_s16(struct demod_multi_s *M,
+                             const int16_t *frames,
+                             int count);
+
+// Same for float audio, full scale = +/-1.0:
+void demod_multi_process_f32(struct demod_multi_s *M,
+                             const float *frames,
+                             int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DEMOD_MULTI_H */
@@ -0,0 +1,70 @@
+// File: receive/src/viperwolf/c/include/demod_sched.h
+//
+// Worker pool for many demodulator instances. Each channel is assigned to
+// one worker when it is added and stays there, so its demodulator_state_s
+// is only ever touched by one thread (and, with pinning, one core's
+// cache). The caller hands over one block per channel per round; each
+// worker gets all of its channels' blocks with a single wakeup.
+
+#ifndef DEMOD_SCHED_H
+#define DEMOD_SCHED_H
+
+#include <stdint.h>
+#include "demod_afsk.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct demod_sched_s;
+
+// Per-worker counters since creation or the last demod_sched_reset_stats().
+struct demod_sched_stats_s {
+    int cpu;                // core the worker is pinned to, -1 if not pinned
+    int channels;           // channels assigned to it
+    long blocks;            // blocks demodulated
+    long samples;           // samples demodulated
+    double busy_sec;        // time spent demodulating
+    double wall_sec;        // time elapsed
+    double utilization;     // busy_sec / wall_sec
+};
+
+// Start 'num_workers' threads (0 = one per CPU this process may run on)
+// for up to 'max_chans' channels. pin: 1 = pin worker i to the i-th
+// allowed CPU (Linux only, ignored elsewhere). Returns NULL if max_chans
+// is below 1, out of memory, or no thread could be started.
+struct demod_sched_s *demod_sched_create(int num_workers, int pin, int max_chans);
+
+// Stop and join the workers. The demodulators themselves are the caller's.
+void demod_sched_free(struct demod_sched_s *S);
+
+int demod_sched_num_workers(const struct demod_sched_s *S);
+
+// Add an initialized demodulator, to be processed as channel 'chan'; its
+// bits go to its own queues (demod_afsk_queue()), which the caller may
+// drain at any time, also during a round. It joins the worker with the
+// fewest channels. Returns the channel's slot
+// (0, 1, 2... in the order added), or -1 when max_chans are added.
+int demod_sched_add(struct demod_sched_s *S, int chan, struct demodulator_state_s *D);
+
+// One round: demodulate blocks[i] (counts[i] samples) on slot i, for
+// every slot, and return when all are done. A count of 0 skips a slot.
+void demod_sched_process_s16(struct demod_sched_s *S,
+                             const int16_t *const *blocks,
+                             const int *counts);
+
+// Same for float samples, full scale = +/-1.0:
+void demod_sched_process_f32(struct demod_sched_s *S,
+                             const float *const *blocks,
+                             const int *counts);
+
+void demod_sched_get_stats(const struct demod_sched_s *S, int worker,
+                           struct demod_sched_stats_s *stats);
+
+void demod_sched_reset_stats(struct demod_sched_s *S);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DEMOD_SCHED_H */
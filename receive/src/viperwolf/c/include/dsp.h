@@ -3,11 +3,37 @@
 #ifndef DSP_H
 #define DSP_H
 
+#include <math.h>
 #include "fsk_demod_state.h"
 
+// Stopband attenuation BP_WINDOW_KAISER is set up for in window(),
+// gen_lowpass() and gen_bandpass().
+#define KAISER_DEFAULT_ATTEN_DB 60.0f
+
+// How the spec-sized filters are designed, see gen_bandpass_spec().
+enum filter_design_e {
+    FILTER_DESIGN_FIXED=0,      // not spec sized: fixed lengths and windows
+    FILTER_DESIGN_KAISER,       // Kaiser-windowed sinc
+    FILTER_DESIGN_EQUIRIPPLE    // Parks-McClellan
+};
+
+// Target response for gen_bandpass_spec() / gen_lowpass_spec().
+struct filter_spec_s {
+    float trans;        // transition band width, fraction of sample rate
+    float atten_db;     // stopband attenuation
+    float ripple_db;    // passband ripple, peak to peak (equiripple only)
+};
+
 // Minimal stubs for bandpass, lowpass, RRC:
 float window (bp_window_t type, int size, int j);
 
+float window_kaiser(int size, int j, float beta);
+
+// Kaiser's beta and tap count for a stopband attenuation and transition
+// width (fraction of sample rate):
+float window_kaiser_beta(float atten_db);
+int kaiser_taps(float atten_db, float trans);
+
 void gen_lowpass(float fc, float *lp_filter, int filter_size, bp_window_t wtype);
 
 void gen_bandpass(float f1, float f2, float *bp_filter, int filter_size, bp_window_t wtype);
@@ -16,4 +42,48 @@ float rrc(float t, float a);
 
 void gen_rrc_lowpass(float *pfilter, int taps, float rolloff, float sps);
 
+// Parks-McClellan, odd 'taps' only: bands as 2*nbands increasing edges
+// (fraction of sample rate) with a desired amplitude and weight each.
+// Returns 1 when the exchange converged.
+int gen_equiripple(float *h, int taps, int nbands,
+                   const float *edges, const float *desired, const float *weight);
+
+// Filters sized to meet 'spec' (capped at max_taps), design is a
+// filter_design_e; f1, f2 and fc are passband edges, the stopbands start
+// spec->trans further out. Return the tap count.
+int gen_bandpass_spec(float f1, float f2, const struct filter_spec_s *spec, int design,
+                      float *bp_filter, int max_taps);
+
+int gen_lowpass_spec(float fc, const struct filter_spec_s *spec, int design,
+                     float *lp_filter, int max_taps);
+
+// Minimum-phase filter with the same taps and magnitude response, in
+// place, via the cepstrum. Returns 0 (filter unchanged) if out of memory.
+int make_min_phase(float *filter, int taps);
+
+int is_symmetric(const float *filter, int taps);
+
+int quantize_q15(const float *filter, int taps, int16_t *q);
+
+// Bandpass biquad cascade, f1..f2 as fractions of the sample rate: a
+// 'sections'-order lowpass prototype (1..IIR_MAX_SECTIONS), so 2*sections
+// poles. Returns the number of sections written to sos, 0 if the band
+// cannot be designed.
+int gen_iir_bandpass(float f1, float f2, int sections, iir_type_t type,
+                     float ripple_db, struct biquad_s *sos);
+
+// atan2 via octant reduction and a 9th-order odd polynomial (Abramowitz &
+// Stegun 4.4.49), good to about 1e-5 rad.
+static inline float fast_atan2f(float y, float x)
+{
+    float ax=fabsf(x), ay=fabsf(y);
+    float mx=(ax>ay)?ax:ay, mn=(ax<ay)?ax:ay;
+    if(mx==0.f) return 0.f;
+    float t=mn/mx, t2=t*t;
+    float a=t*(0.9998660f+t2*(-0.3302995f+t2*(0.1801410f+t2*(-0.0851330f+t2*0.0208351f))));
+    if(ay>ax) a=(float)M_PI_2-a;
+    if(x<0.f) a=(float)M_PI-a;
+    return (y<0.f)?-a:a;
+}
+
 #endif
@@ -0,0 +1,66 @@
+// File: receive/src/viperwolf/c/include/fft.h
+
+#ifndef FFT_H
+#define FFT_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Largest real transform size: overlap-save needs n >= 2*taps, so this
+// covers every filter up to MAX_FILTER_SIZE (fsk_demod_state.h).
+#define FFT_MAX_SIZE 8192
+
+// Radix-2 real FFT of size n, computed as an n/2-point complex FFT plus a
+// split step. Spectra are n/2+1 interleaved (re,im) pairs. The tables
+// live in fft_table_size(n) bytes the caller provides; they are only read
+// once set up, so any number of threads may share them.
+struct fft_s {
+    int n;
+    int *rev;                       // n/2: bit reversal for the n/2-point FFT
+    float *tw;                      // n/2: exp(-j*2*pi*k/(n/2)), k < n/4
+    float *rtw;                     // n: exp(-j*2*pi*k/n), k < n/2
+};
+
+// Bytes of tables for size n; 0 if n is not supported.
+size_t fft_table_size(int n);
+
+int fft_init(struct fft_s *F, int n, void *tables);
+
+void fft_real_forward(const struct fft_s *F, const float *in, float *spec);
+
+// Unscaled: returns n/2 times the input of fft_real_forward().
+void fft_real_inverse(const struct fft_s *F, float *spec, float *out);
+
+// Overlap-save FIR for block input. Each FFT yields 'block' new outputs.
+// The transform and filter spectrum are fixed by the coefficients and can
+// be shared by every instance running them; each instance only needs its
+// own work buffer of ols_work_size() bytes.
+struct ols_s {
+    struct fft_s fft;
+    int taps;
+    int block;
+    float *H;                       // n+2: filter spectrum, inverse scaling folded in
+};
+
+// Bytes ols_init() takes at 'mem' for a filter of 'taps' coefficients
+// (spectrum and FFT tables); 0 if the filter is too long for FFT_MAX_SIZE.
+size_t ols_size(int taps);
+
+// Returns 0 if the filter is too long for FFT_MAX_SIZE.
+int ols_init(struct ols_s *O, const float *filt, int taps, void *mem);
+
+size_t ols_work_size(const struct ols_s *O);
+
+// Filter 'count' (<= O->block) new samples. 'hist' is the newest-first
+// window of the preceding taps-1 input samples, as kept by a delay line.
+void ols_process(const struct ols_s *O, float *work, const float *hist,
+                 const float *in, float *out, int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FFT_H */
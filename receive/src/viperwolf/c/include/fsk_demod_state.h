@@ -4,25 +4,145 @@
 #define FSK_DEMOD_STATE_H
 
 #include <stdint.h>
+#include "convolve.h"
+#include "fft.h"
+#include "viperwolf.h"
 
 // minimal window enum
 typedef enum bp_window_e {
     BP_WINDOW_TRUNCATED,
-    BP_WINDOW_COSINE
+    BP_WINDOW_COSINE,
+    BP_WINDOW_KAISER,           // beta from window_kaiser_beta(), see dsp.h
+    BP_WINDOW_BLACKMAN_HARRIS   // 4-term, about 92 dB sidelobes
 } bp_window_t;
 
+// Prefilter response, see demod_afsk_opts_s.prefilter_iir.
+typedef enum iir_type_e {
+    IIR_NONE=0,         // FIR from gen_bandpass()
+    IIR_BUTTERWORTH,
+    IIR_CHEBYSHEV
+} iir_type_t;
+
+// One second-order section:
+// H(z) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2)
+struct biquad_s {
+    float b0, b1, b2;
+    float a1, a2;
+};
+
+// One SSE vector of sections: up to an 8-pole bandpass.
+#define IIR_MAX_SECTIONS 4
+
+// Biquad cascade, transposed direct form II, one array per coefficient so
+// a step over all sections is one vector operation (see iir_block() in
+// demod_afsk.c). Sections past 'sections' pass their input through.
+struct iir_cascade_s {
+    int sections;
+    float b0[IIR_MAX_SECTIONS], b1[IIR_MAX_SECTIONS], b2[IIR_MAX_SECTIONS];
+    float a1[IIR_MAX_SECTIONS], a2[IIR_MAX_SECTIONS];
+    float s1[IIR_MAX_SECTIONS], s2[IIR_MAX_SECTIONS];
+    float y[IIR_MAX_SECTIONS];  // last output of each section
+};
+
 #define TICKS_PER_PLL_CYCLE (256.0*256.0*256.0*256.0)
-#define MAX_FILTER_SIZE 480
+// Longest filter demod_afsk_init_opts() will design (300 baud at 192 kHz
+// needs about 1800 taps). Instances only store the taps they use.
+#define MAX_FILTER_SIZE 4096
+
+// Mirrored circular delay line. Each sample is written at [pos] and
+// [pos+size], so buf+pos is always a contiguous, newest-first window of
+// the last 'size' samples and nothing ever has to be shifted. buf holds
+// 2*size samples, or hbuf the same in 16 bits with
+// demod_afsk_opts_s.half_storage; see "Arrays" below for where.
+struct delay_line_s {
+    int pos;
+    union {
+        float *buf;
+        uint16_t *hbuf;
+    };
+};
+
+// Lane-interleaved variants for streams that share one filter: lane j of
+// the sample pushed k steps ago is at buf[(pos+k)*lanes+j], so a single FIR
+// pass reads each coefficient once for all lanes.
+struct delay_line2_s {
+    int pos;
+    union {
+        float *buf;
+        uint16_t *hbuf;
+    };
+};
+
+struct delay_line4_s {
+    int pos;
+    union {
+        float *buf;
+        uint16_t *hbuf;
+    };
+};
+
+// int16 delay lines for the fixed-point path. Planar: one mirrored line per
+// stream, since the int16 multiply-add instructions pair neighbouring
+// elements and so cannot use the lane-interleaved layout.
+struct delay_line_q15_s {
+    int pos;
+    int16_t *buf;
+};
+
+struct delay_line_q15x4_s {
+    int pos;
+    int16_t *buf[4];
+};
 
+struct demodulator_state_s;
+struct coef_set_s;
+struct my_fsk_queue_s;
+
+// Demodulator outputs a slicer can decide on. Only profile C has the
+// per-detector ones; elsewhere every slicer uses DEMOD_OUT_MAIN.
+enum demod_out_e {
+    DEMOD_OUT_MAIN=0,
+    DEMOD_OUT_A,            // profile C: envelope detector alone
+    DEMOD_OUT_B,            // profile C: discriminator alone
+    DEMOD_OUT_COUNT
+};
+
+// Float path for a chunk of up to BLOCK_CHUNK samples (demod_afsk.c; scaled
+// like sam/16384), bound at init to a generic or specialized implementation.
+typedef void (*demod_chunk_fn)(int chan, int subchan, const float *in, int count,
+                               struct demodulator_state_s *D);
+
+// Per-instance state. The filters and delay lines are not in the struct.
+// The filters belong to a coefficient set that every instance with the
+// same settings shares (reference counted, see demod_afsk.c) and are
+// read-only. The delay lines are sized to the instance's tap counts at
+// init and sit in one block of 64-byte aligned arrays, right after the
+// struct with demod_afsk_init_in() or allocated on their own otherwise;
+// demod_afsk_release() gives up both. Arrays a profile or path does not
+// use are not allocated.
 struct demodulator_state_s {
-    char profile; // 'A' or 'B'
+    char profile; // 'A'/'E', 'B'/'D', 'C' (both) or 'G' (sliding DFT)
+    int fixed;    // 1 = Q15 integer path (see 'q' below)
+    demod_chunk_fn process_chunk;
+
+    // FIR kernels picked at init: instruction set from convolve_select(),
+    // folded variants when the filter is symmetric.
+    const struct convolve_ops_s *fir;
+    convolve_fn pre_conv;
+    convolve2_fn lp_conv2;
+    convolve4_fn lp_conv4;
+    const struct convolve_half_ops_s *half;  // 16-bit delay lines, or NULL
 
-    int pll_step_per_sample;
+    int pll_step_per_sample;    // per processed sample, i.e. scaled by decimate
+
+    int decimate;               // lowpass/AGC/PLL run every Nth input sample
+    int decim_count;            // input samples until the next output
 
     bp_window_t lp_window;
 
     float lpf_baud;
     float lp_filter_width_sym;
+    float lp_trans_baud;        // same for the spec-sized (non-RRC) lowpass
     int lp_filter_taps;
 
     float agc_fast_attack;
@@ -34,13 +154,21 @@ struct demodulator_state_s {
     int use_prefilter;
     float prefilter_baud;
     float pre_filter_len_sym;
+    float pre_trans_baud;       // spec-sized prefilter: transition width / baud
     bp_window_t pre_window;
     int pre_filter_taps;
 
-    float pre_filter[MAX_FILTER_SIZE];
-    float raw_cb[MAX_FILTER_SIZE];
+    float *pre_filter;
+    struct delay_line_s raw_cb;     // prefilter input; profile G's window
+
+    int use_ols;                // block input takes the overlap-save prefilter
+    const struct ols_s *pre_ols;    // its spectrum, in the coefficient set
+    float *ols_work;                // and this instance's transform buffer
 
-    float lp_filter[MAX_FILTER_SIZE];
+    int use_iir;                // prefilter is pre_iir instead of pre_filter
+    struct iir_cascade_s pre_iir;
+
+    float *lp_filter;
 
     int num_slicers;
     float m_peak,s_peak;
@@ -53,39 +181,98 @@ struct demodulator_state_s {
     union {
         // AFSK only
         struct {
-            unsigned int m_osc_phase;
-            unsigned int m_osc_delta;
-            unsigned int s_osc_phase;
-            unsigned int s_osc_delta;
+            uint32_t     m_osc_phase;
+            uint32_t     m_osc_delta;
+            uint32_t     s_osc_phase;
+            uint32_t     s_osc_delta;
 
-            unsigned int c_osc_phase;
-            unsigned int c_osc_delta;
+            uint32_t     c_osc_phase;
+            uint32_t     c_osc_delta;
 
-            float m_I_raw[MAX_FILTER_SIZE];
-            float m_Q_raw[MAX_FILTER_SIZE];
-            float s_I_raw[MAX_FILTER_SIZE];
-            float s_Q_raw[MAX_FILTER_SIZE];
+            // Profile A: (m_I, m_Q, s_I, s_Q) per time step.
+            struct delay_line4_s ms_IQ_raw;
 
-            float c_I_raw[MAX_FILTER_SIZE];
-            float c_Q_raw[MAX_FILTER_SIZE];
+            // Profile B: (c_I, c_Q) per time step.
+            struct delay_line2_s c_IQ_raw;
 
             int use_rrc;
             float rrc_width_sym;
             float rrc_rolloff;
 
+            // Profile C: the B detector's own lowpass, on the middle of
+            // c_IQ_raw (pushed at the length of lp_filter, which A uses).
+            float c_rrc_width_sym;
+            float c_rrc_rolloff;
+            int c_lp_filter_taps;
+            int c_lp_offset;
+            float *c_lp_filter;
+            struct combine_level_s {
+                float mean_abs, mean_sq;
+            } combine[2];               // A, B
+            float combine_alpha;
+
+            // Profile G: sliding DFT bins (re, im) at mark and space over
+            // sdft_len samples of raw_cb, with their per-sample rotation
+            // and the factor on the sample leaving the window.
+            int sdft_len;
+            float sdft_bin[2][2];
+            float sdft_rot[2][2];
+            float sdft_tail[2][2];
+
+            int fm_disc;                // enum fm_disc_e
             float prev_phase;
+            float prev_I, prev_Q;       // last lowpass output, FM_DISC_CONJ/CROSS
+            float prev_power;
             float normalize_rpsam;
         } afsk;
     } u;
 
-    // Single slicer:
+    // Fixed-point path: Q15 filters with a per-filter shift (quantize_q15),
+    // AGC levels in amplitude<<AGC_Q_FRAC and Q24 AGC constants (the Q16 PLL
+    // constants are per slicer).
+    struct {
+        int16_t *pre_filter;
+        int pre_shift;
+        int16_t *lp_filter;
+        int lp_shift;
+
+        struct delay_line_q15_s raw_cb;
+        struct delay_line_q15x4_s IQ_raw;   // A: mI,mQ,sI,sQ  B: cI,cQ
+
+        int32_t agc_fast_attack;
+        int32_t agc_slow_decay;
+        int32_t m_peak,m_valley;
+        int32_t s_peak,s_valley;
+
+        int16_t prev_phase;                 // binary angle, 65536 per turn
+    } q;
+
+    // Slicers on the demodulator output, each with its own decision
+    // threshold, PLL and bit queue (bits[]). Slicer 0 has threshold 0 and
+    // the profile's inertias.
     struct {
         signed int data_clock_pll;
         signed int prev_d_c_pll;
 
         int prev_demod_data;
         int data_detect;
-    } slicer[1];
+
+        int source;             // enum demod_out_e
+        float threshold;
+        float locked_inertia;
+        float searching_inertia;
+
+        // Fixed-point path: threshold on its demod_out scale, Q16 inertias.
+        int32_t q_threshold;
+        int32_t q_locked_inertia;
+        int32_t q_searching_inertia;
+    } slicer[MAX_SLICERS];
+
+    struct my_fsk_queue_s *bits;    // num_queues of them, in 'arrays'
+    int num_queues;                 // slicers that have a queue
+    struct coef_set_s *coef;        // shared filters, see below
+    void *arrays;                   // the instance's own arrays
+    void *owned;                    // the same if init allocated them
 };
 
 #endif
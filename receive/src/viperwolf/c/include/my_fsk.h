@@ -3,18 +3,50 @@
 #ifndef MY_FSK_H
 #define MY_FSK_H
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// Called once per demodulated bit. 'bit' is 0 or 1.
-void my_fsk_rec_bit(int bit);
+// Queue of raw bits, packed 64 to a word. Every demodulator owns one per
+// slicer (demod_afsk_queue(), demod_multi_queue()), so instances never see
+// each other's bits. Single producer, single consumer, lock-free: the
+// thread demodulating puts, any one other thread may take at the same
+// time. Bits are taken in order, bit i of a packed result being the i-th
+// bit taken (least significant first). If full, new bits are dropped.
+#define MY_FSK_QUEUE_BITS 8192
+#define MY_FSK_QUEUE_WORDS (MY_FSK_QUEUE_BITS/64)
+
+struct my_fsk_queue_s {
+    // Bits ever put and taken. Each is written by one side only and read
+    // by the other with acquire/release ordering; separate cache lines so
+    // the two sides do not contend.
+    uint64_t head __attribute__((aligned(64)));
+    uint64_t tail __attribute__((aligned(64)));
+    uint64_t words[MY_FSK_QUEUE_WORDS] __attribute__((aligned(64)));
+};
+
+// Empty queue. Zeroed memory is one too.
+void my_fsk_queue_init(struct my_fsk_queue_s *q);
+
+// Producer: append 'bit' (0 or 1). Returns 0 if the queue was full.
+int my_fsk_queue_put(struct my_fsk_queue_s *q, int bit);
+
+// Consumer: bits waiting.
+int my_fsk_queue_count(const struct my_fsk_queue_s *q);
+
+// Consumer: take up to 'max_bits' bits, one int per bit. Returns how many.
+int my_fsk_queue_get_bits(struct my_fsk_queue_s *q, int *out_bits, int max_bits);
 
-// Retrieve up to 'max_bits' from ring buffer
-int my_fsk_get_bits(int *out_bits, int max_bits);
+// Consumer: the same packed, 64 bits per word / 8 per byte; the last one
+// is zero-padded. 'out' holds at least (max_bits+63)/64 words or
+// (max_bits+7)/8 bytes. Returns the number of bits.
+int my_fsk_queue_get_words(struct my_fsk_queue_s *q, uint64_t *out, int max_bits);
+int my_fsk_queue_get_bytes(struct my_fsk_queue_s *q, uint8_t *out, int max_bits);
 
-// Clear the ring buffer
-void my_fsk_clear_buffer(void);
+// Consumer: drop the bits waiting.
+void my_fsk_queue_clear(struct my_fsk_queue_s *q);
 
 #ifdef __cplusplus
 }
@@ -8,15 +8,16 @@
 #include <stdlib.h>
 #include <math.h>
 
-// Single-subchannel approach:
+// Up to MAX_CHANS audio channels (see demod_multi.h), each with a single
+// subchannel and up to MAX_SLICERS slicers on its demodulator output:
 #ifndef MAX_CHANS
-  #define MAX_CHANS 1
+  #define MAX_CHANS 16
 #endif
 #ifndef MAX_SUBCHANS
   #define MAX_SUBCHANS 1
 #endif
 #ifndef MAX_SLICERS
-  #define MAX_SLICERS 1
+  #define MAX_SLICERS 9
 #endif
 
 #endif /* DIREWOLF_H */
@@ -1,42 +1,104 @@
 // File: receive/src/direwolf/c/my_fsk.c
 //
-// Minimal ring buffer for raw bits. 
-// If full, drop new bits.
+// Packed single-producer/single-consumer bit queues, see my_fsk.h.
+//
+// head and tail count bits and never wrap in practice. The producer writes
+// a bit into its word with a relaxed load and store, then publishes it by
+// storing head with release; the consumer loads head with acquire before
+// reading the words, and hands the space back by storing tail with
+// release. A word may hold bits of both sides at once (the producer's
+// newest next to the consumer's oldest), which is why the words, too, are
+// only ever accessed atomically.
 
 #include <string.h>
 #include "my_fsk.h"
 
-#define MY_FSK_RING_SIZE 8192
+#define LOAD(p,order)    __atomic_load_n(p,__ATOMIC_##order)
+#define STORE(p,v,order) __atomic_store_n(p,v,__ATOMIC_##order)
+
+void my_fsk_queue_init(struct my_fsk_queue_s *q)
+{
+    memset(q,0,sizeof(*q));
+}
+
+int my_fsk_queue_put(struct my_fsk_queue_s *q,int bit)
+{
+    uint64_t h=LOAD(&q->head,RELAXED);
+    if(h-LOAD(&q->tail,ACQUIRE)>=MY_FSK_QUEUE_BITS){
+        // queue full, drop
+        return 0;
+    }
+    uint64_t *w=&q->words[(h/64)%MY_FSK_QUEUE_WORDS];
+    uint64_t m=(uint64_t)1<<(h%64);
+    uint64_t v=LOAD(w,RELAXED);
+    STORE(w,bit?(v|m):(v&~m),RELAXED);
+    STORE(&q->head,h+1,RELEASE);
+    return 1;
+}
+
+int my_fsk_queue_count(const struct my_fsk_queue_s *q)
+{
+    return (int)(LOAD(&q->head,ACQUIRE)-LOAD(&q->tail,RELAXED));
+}
 
-static int s_ring[MY_FSK_RING_SIZE];
-static int s_head=0;
-static int s_tail=0;
+// Up to 'max_bits' waiting bits start at *t.
+static int available(const struct my_fsk_queue_s *q,int max_bits,uint64_t *t)
+{
+    *t=LOAD(&q->tail,RELAXED);
+    uint64_t n=LOAD(&q->head,ACQUIRE)-*t;
+    if(max_bits<0) max_bits=0;
+    return (n<(uint64_t)max_bits)?(int)n:max_bits;
+}
+
+// 'k' (1..64) bits from bit position 'pos', the first in bit 0.
+static uint64_t peek(const struct my_fsk_queue_s *q,uint64_t pos,int k)
+{
+    int i=(int)((pos/64)%MY_FSK_QUEUE_WORDS), off=(int)(pos%64);
+    uint64_t v=LOAD(&q->words[i],RELAXED)>>off;
+    if(off && k>64-off){
+        v|=LOAD(&q->words[(i+1)%MY_FSK_QUEUE_WORDS],RELAXED)<<(64-off);
+    }
+    return (k<64)?(v&(((uint64_t)1<<k)-1)):v;
+}
+
+int my_fsk_queue_get_words(struct my_fsk_queue_s *q,uint64_t *out,int max_bits)
+{
+    uint64_t t;
+    int n=available(q,max_bits,&t);
+    for(int i=0;i<n;i+=64){
+        out[i/64]=peek(q,t+i,(n-i<64)?n-i:64);
+    }
+    STORE(&q->tail,t+n,RELEASE);
+    return n;
+}
 
-void my_fsk_rec_bit(int bit)
+int my_fsk_queue_get_bytes(struct my_fsk_queue_s *q,uint8_t *out,int max_bits)
 {
-    int next=(s_head+1)%MY_FSK_RING_SIZE;
-    if(next==s_tail){
-        // ring full, drop
-        return;
+    uint64_t t;
+    int n=available(q,max_bits,&t);
+    for(int i=0;i<n;i+=64){
+        int k=(n-i<64)?n-i:64;
+        uint64_t v=peek(q,t+i,k);
+        for(int j=0;j<(k+7)/8;j++) out[i/8+j]=(uint8_t)(v>>(8*j));
     }
-    s_ring[s_head]=bit;
-    s_head=next;
+    STORE(&q->tail,t+n,RELEASE);
+    return n;
 }
 
-int my_fsk_get_bits(int *out,int max_bits)
+int my_fsk_queue_get_bits(struct my_fsk_queue_s *q,int *out,int max_bits)
 {
-    int count=0;
-    while(count<max_bits && s_tail!=s_head){
-        out[count]=s_ring[s_tail];
-        s_tail=(s_tail+1)%MY_FSK_RING_SIZE;
-        count++;
+    uint64_t t;
+    int n=available(q,max_bits,&t);
+    for(int i=0;i<n;i+=64){
+        int k=(n-i<64)?n-i:64;
+        uint64_t v=peek(q,t+i,k);
+        for(int j=0;j<k;j++) out[i+j]=(int)((v>>j)&1);
     }
-    return count;
+    STORE(&q->tail,t+n,RELEASE);
+    return n;
 }
 
-void my_fsk_clear_buffer(void)
+void my_fsk_queue_clear(struct my_fsk_queue_s *q)
 {
-    s_head=0;
-    s_tail=0;
-    memset(s_ring,0,sizeof(s_ring));
+    STORE(&q->tail,LOAD(&q->head,ACQUIRE),RELEASE);
 }
@@ -0,0 +1,44 @@
+// File: receive/src/viperwolf/c/nco.c
+//
+// Table-driven oscillator used by the AFSK mixers, see nco.h.
+
+#include <math.h>
+#include <pthread.h>
+#include "nco.h"
+
+float nco_table[2*NCO_TABLE_SIZE];
+int16_t nco_table_q15[2*NCO_TABLE_SIZE];
+
+static pthread_once_t nco_once=PTHREAD_ONCE_INIT;
+
+static void nco_fill_tables(void)
+{
+    for(int i=0;i<NCO_TABLE_SIZE;i++){
+        double c0=cos(2.*M_PI*i/NCO_TABLE_SIZE);
+        double c1=cos(2.*M_PI*(i+1)/NCO_TABLE_SIZE);
+        nco_table[2*i]=(float)c0;
+        nco_table[2*i+1]=(float)(c1-c0);
+
+        int q0=(int)lrint(32767.*c0), q1=(int)lrint(32767.*c1);
+        nco_table_q15[2*i]=(int16_t)q0;
+        nco_table_q15[2*i+1]=(int16_t)(q1-q0);
+    }
+}
+
+// The tables are only ever written here, once, before any caller of
+// nco_init_tables() returns; after that every thread just reads them.
+void nco_init_tables(void)
+{
+    pthread_once(&nco_once,nco_fill_tables);
+}
+
+void nco_block(uint32_t *phase, uint32_t delta, int count, float *c, float *s)
+{
+    uint32_t p0=*phase;
+    for(int i=0;i<count;i++){
+        uint32_t p=p0+(uint32_t)i*delta;
+        c[i]=nco_cos(p);
+        s[i]=nco_sin(p);
+    }
+    *phase=p0+(uint32_t)count*delta;
+}
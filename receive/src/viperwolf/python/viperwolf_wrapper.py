@@ -1,13 +1,67 @@
 # File: receive/src/viperwolf/python/viperwolf_wrapper.py
 
 import os
+import numpy as np
 from cffi import FFI
 
+def _open_library():
+    """
+    Declare the C interface and load the extension. Returns (ffi, lib).
+    """
+    ffi = FFI()
+    ffi.cdef("""
+        typedef struct demodulator_state_s demodulator_state_s;
+
+        demodulator_state_s * create_demodulator_state(void);
+        void free_demodulator_state(demodulator_state_s *p);
+
+        void demod_afsk_init(int, int, int, int, char, demodulator_state_s*);
+        void demod_afsk_process_sample(int, int, int, demodulator_state_s*);
+        void demod_afsk_process_block_s16(int, int, const int16_t*, int, demodulator_state_s*);
+        void demod_afsk_process_block_f32(int, int, const float*, int, demodulator_state_s*);
+
+        typedef struct my_fsk_queue_s my_fsk_queue_s;
+
+        int my_fsk_queue_get_bits(my_fsk_queue_s *q, int *out_bits, int max_bits);
+        int my_fsk_queue_get_bytes(my_fsk_queue_s *q, uint8_t *out, int max_bits);
+        void my_fsk_queue_clear(my_fsk_queue_s *q);
+        my_fsk_queue_s * demod_afsk_queue(demodulator_state_s*, int slicer);
+        void demod_afsk_clear_bits(demodulator_state_s*);
+
+        int demod_afsk_set_slicer(demodulator_state_s*, int, float, float, float);
+
+        typedef struct demod_multi_s demod_multi_s;
+        typedef struct demod_afsk_opts_s demod_afsk_opts_s;
+
+        demod_multi_s * demod_multi_create(int, int, int, int, int, char, const demod_afsk_opts_s*);
+        void demod_multi_free(demod_multi_s *M);
+        void demod_multi_process_s16(demod_multi_s *M, const int16_t*, int);
+        void demod_multi_process_f32(demod_multi_s *M, const float*, int);
+        my_fsk_queue_s * demod_multi_queue(demod_multi_s *M, int chan);
+    """)
+
+    # The .so is placed next to this file by build_viperwolf.py
+    current_dir = os.path.dirname(__file__)
+    so_path = os.path.join(current_dir, "_viperwolf_demod.so")
+    return ffi, ffi.dlopen(so_path)
+
+
+def _get_bits(ffi, lib, q, max_bits):
+    out_array = ffi.new("int[]", max_bits)
+    count = lib.my_fsk_queue_get_bits(q, out_array, max_bits)
+    return [out_array[i] for i in range(count)]
+
+
+def _get_packed_bits(ffi, lib, q, max_bits):
+    out = np.zeros((max_bits + 7) // 8, dtype=np.uint8)
+    count = lib.my_fsk_queue_get_bytes(q, ffi.from_buffer("uint8_t[]", out), max_bits)
+    return out[:(count + 7) // 8], count
+
+
 class ViperwolfFSKDecoder:
     def __init__(self, sample_rate=48000, baud_rate=300,
-                 mark_freq=1200, space_freq=2200):
-        self.ffi = FFI()
-        self._init_ffi()
+                 mark_freq=1200, space_freq=2200, profile=b'A'):
+        self.ffi, self.lib = _open_library()
 
         # ---- Create a new demodulator_state_s using the factory in C.
         self.demod_state = self.lib.create_demodulator_state()
@@ -20,30 +74,10 @@ class ViperwolfFSKDecoder:
             baud_rate,
             mark_freq,
             space_freq,
-            b'A',
+            profile,
             self.demod_state
         )
 
-    def _init_ffi(self):
-        self.ffi.cdef("""
-            typedef struct demodulator_state_s demodulator_state_s;
-
-            demodulator_state_s * create_demodulator_state(void);
-            void free_demodulator_state(demodulator_state_s *p);
-
-            void demod_afsk_init(int, int, int, int, char, demodulator_state_s*);
-            void demod_afsk_process_sample(int, int, int, demodulator_state_s*);
-
-            void my_fsk_rec_bit(int bit);
-            int my_fsk_get_bits(int *out_bits, int max_bits);
-            void my_fsk_clear_buffer(void);
-        """)
-
-        # The .so is placed next to this file by build_viperwolf.py
-        current_dir = os.path.dirname(__file__)
-        so_path = os.path.join(current_dir, "_viperwolf_demod.so")
-        self.lib = self.ffi.dlopen(so_path)
-
     def __del__(self):
         """
         Optional destructor to free the allocated struct and avoid memory leaks.
@@ -55,18 +89,117 @@ class ViperwolfFSKDecoder:
     def process_samples(self, samples):
         """
         Feed a list or array of float samples [-1..+1].
+        The whole chunk crosses into C in one call.
+        """
+        scaled = np.clip(np.asarray(samples, dtype=np.float64) * 32767,
+                         -32768, 32767).astype(np.int16)
+        if len(scaled) == 0:
+            return
+        buf = self.ffi.from_buffer("int16_t[]", scaled)
+        self.lib.demod_afsk_process_block_s16(0, 0, buf, len(scaled), self.demod_state)
+
+    def set_slicer(self, slicer, threshold, locked_inertia=0.74,
+                   searching_inertia=0.50):
+        """
+        Enable slicer 'slicer' (and all below it), deciding at 'threshold'
+        on the demodulator output (+/-1 at the tones).
+        """
+        if not self.lib.demod_afsk_set_slicer(self.demod_state, slicer, threshold,
+                                              locked_inertia, searching_inertia):
+            raise ValueError("slicer out of range")
+
+    def _queue(self, slicer):
+        q = self.lib.demod_afsk_queue(self.demod_state, slicer)
+        if q == self.ffi.NULL:
+            raise ValueError("slicer out of range")
+        return q
+
+    def get_raw_bits(self, max_bits=1024, slicer=0):
+        """
+        Retrieve up to 'max_bits' bits from this decoder's queue in C.
+        With profile b'C', slicers 1 and 2 carry the A and B detectors
+        alone (set_slicer(2, 0.0) enables both).
+        """
+        return _get_bits(self.ffi, self.lib, self._queue(slicer), max_bits)
+
+    def get_packed_bits(self, max_bits=8192, slicer=0):
+        """
+        Same as get_raw_bits(), packed 8 bits per byte, first bit in the
+        least significant one. Returns (uint8 array, number of bits);
+        np.unpackbits(a, count=n, bitorder='little') unpacks them.
+        """
+        return _get_packed_bits(self.ffi, self.lib, self._queue(slicer), max_bits)
+
+    def clear_ring_buffer(self):
+        self.lib.demod_afsk_clear_bits(self.demod_state)
+
+
+
+class ViperwolfMultiFSKDecoder:
+    """
+    Several channels with the same modem settings, e.g. all inputs of a
+    multi-channel sound card. Bits of channel j come out of queue j.
+    """
+    def __init__(self, num_chans, sample_rate=48000, baud_rate=300,
+                 mark_freq=1200, space_freq=2200, profile=b'A'):
+        self.ffi, self.lib = _open_library()
+        self.num_chans = num_chans
+
+        self.multi = self.lib.demod_multi_create(
+            num_chans,
+            sample_rate,
+            baud_rate,
+            mark_freq,
+            space_freq,
+            profile,
+            self.ffi.NULL
+        )
+        if not self.multi:
+            raise ValueError("demod_multi_create() failed (bad arguments or out of memory)")
+
+    def __del__(self):
+        if getattr(self, 'multi', None):
+            self.lib.demod_multi_free(self.multi)
+            self.multi = None
+
+    def process_samples(self, samples):
+        """
+        Feed float samples [-1..+1], shaped (frames, num_chans) or
+        already interleaved. Only whole frames are accepted.
+        """
+        data = np.asarray(samples, dtype=np.float32)
+        if data.ndim == 2:
+            if data.shape[1] != self.num_chans:
+                raise ValueError("expected %d channels, got %d" % (self.num_chans, data.shape[1]))
+        elif data.ndim != 1 or len(data) % self.num_chans:
+            raise ValueError("expected (frames, %d) samples or a multiple of %d interleaved"
+                             % (self.num_chans, self.num_chans))
+        data = np.ascontiguousarray(data).reshape(-1)
+        frames = len(data) // self.num_chans
+        if frames == 0:
+            return
+        buf = self.ffi.from_buffer("float[]", data)
+        self.lib.demod_multi_process_f32(self.multi, buf, frames)
+
+    def _queue(self, chan):
+        q = self.lib.demod_multi_queue(self.multi, chan)
+        if q == self.ffi.NULL:
+            raise ValueError("channel out of range")
+        return q
+
+    def get_raw_bits(self, max_bits=1024, chan=0):
+        """
+        Retrieve up to 'max_bits' bits of channel 'chan', as
+        ViperwolfFSKDecoder.get_raw_bits() does for a slicer.
         """
-        for sample in samples:
-            scaled = int(sample * 32767)
-            self.lib.demod_afsk_process_sample(0, 0, scaled, self.demod_state)
+        return _get_bits(self.ffi, self.lib, self._queue(chan), max_bits)
 
-    def get_raw_bits(self, max_bits=1024):
+    def get_packed_bits(self, max_bits=8192, chan=0):
         """
-        Retrieve up to 'max_bits' bits from ring buffer in C.
+        Packed bits of one channel, as ViperwolfFSKDecoder.get_packed_bits().
         """
-        out_array = self.ffi.new("int[]", max_bits)
-        count = self.lib.my_fsk_get_bits(out_array, max_bits)
-        return [out_array[i] for i in range(count)]
+        return _get_packed_bits(self.ffi, self.lib, self._queue(chan), max_bits)
 
     def clear_ring_buffer(self):
-        self.lib.my_fsk_clear_buffer()
+        for chan in range(self.num_chans):
+            self.lib.my_fsk_queue_clear(self._queue(chan))